@@ -17,6 +17,8 @@ template <class ItemType> BinaryNode<ItemType>::BinaryNode() {
   rightChildPtr = nullptr;
   isThreadedLeft = false;
   isThreadedRight = false;
+  isInBlock = false;
+  occurrences = 1;
 }
 
 /**
@@ -33,6 +35,8 @@ BinaryNode<ItemType>::BinaryNode(const ItemType &anItem) {
   rightChildPtr = nullptr;
   isThreadedLeft = false;
   isThreadedRight = false;
+  isInBlock = false;
+  occurrences = 1;
 }
 
 /**
@@ -148,4 +152,51 @@ void BinaryNode<ItemType>::setLeftThread(const bool isThreaded) {
 template <class ItemType>
 void BinaryNode<ItemType>::setRightThread(const bool isThreaded) {
   isThreadedRight = isThreaded;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Get number of copies of item
+ *
+ * @pre Existing BinaryNode object
+ * @post return number of copies
+ * @return int number of copies
+ */
+template <class ItemType> int BinaryNode<ItemType>::getCount() const {
+  return occurrences;
+}
+
+/**
+ * @brief Set number of copies of item
+ *
+ * @pre copies >= 0
+ * @post number of copies equals parameter, 0 makes the node a
+ *       tombstone that lookups skip
+ * @param copies number of copies
+ */
+template <class ItemType>
+void BinaryNode<ItemType>::setCount(const int copies) {
+  occurrences = copies;
+}
+
+/**
+ * @brief Get if the node lives in a compacted block
+ *
+ * @pre Existing BinaryNode object
+ * @post return if in a block
+ * @return bool true if the node must not be deleted on its own
+ */
+template <class ItemType> bool BinaryNode<ItemType>::getInBlock() const {
+  return isInBlock;
+}
+
+/**
+ * @brief Set if the node lives in a compacted block
+ *
+ * @pre Existing BinaryNode object
+ * @post in block equals parameter
+ * @param inBlock true if the node was built in a block
+ */
+template <class ItemType>
+void BinaryNode<ItemType>::setInBlock(const bool inBlock) {
+  isInBlock = inBlock;
+}
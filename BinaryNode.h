@@ -18,6 +18,11 @@ private:
                         // inorder predecessor
   bool isThreadedRight; // true if the right pointer of a node points to its
                         // inorder successor
+  bool isInBlock;       // true if the node lives in a block made by compact()
+                        // instead of its own heap allocation
+  int occurrences;      // Copies of item the node stands for, more than one
+                        // only in a tree that counts duplicates, 0 for a
+                        // tombstone left by lazy deletion
 public:
   /**
    * @brief Constructor
@@ -123,7 +128,49 @@ public:
    * @param isThreaded param for right threaded
    */
   void setRightThread(const bool isThreaded);
+
+  /**
+   * @brief Get number of copies of item
+   *
+   * @pre Existing BinaryNode object
+   * @post return number of copies
+   * @return int number of copies
+   */
+  int getCount() const;
+
+  /**
+   * @brief Set number of copies of item
+   *
+   * @pre copies >= 0
+   * @post number of copies equals parameter, 0 makes the node a
+   *       tombstone that lookups skip
+   * @param copies number of copies
+   */
+  void setCount(const int copies);
+
+  /**
+   * @brief Get if the node lives in a compacted block
+   *
+   * @pre Existing BinaryNode object
+   * @post return if in a block
+   * @return bool true if the node must not be deleted on its own
+   */
+  bool getInBlock() const;
+
+  /**
+   * @brief Set if the node lives in a compacted block
+   *
+   * @pre Existing BinaryNode object
+   * @post in block equals parameter
+   * @param inBlock true if the node was built in a block
+   */
+  void setInBlock(const bool inBlock);
 }; // end BinaryNode
 
+// The flags share the padding before the count, so a node of int keys
+// stays at four words on a 64 bit build
+static_assert(sizeof(void *) != 8 || sizeof(BinaryNode<int>) == 32,
+              "BinaryNode<int> grew past four words");
+
 #include "BinaryNode.cpp"
 #endif
@@ -0,0 +1,127 @@
+/**
+ * @file BloomFilter.cpp
+ * @brief BloomFilter header that declares BloomFilter class
+ * @author William Susanto and Robel Messele
+ */
+#include "BloomFilter.h"
+
+/**
+ * @brief Hash a key
+ *
+ * @pre none
+ * @post return well mixed 64 bit hash
+ * @param key key to hash
+ * @return uint64_t hash
+ */
+template <class ItemType>
+uint64_t BloomFilter<ItemType>::hashOf(const ItemType &key) {
+  // std::hash of an integer is often the integer itself, so finish it with
+  // the MurmurHash3 mixer to spread the bits
+  uint64_t hash = (uint64_t)std::hash<ItemType>()(key);
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+/**
+ * @brief Get bit of a word picked by a hash
+ *
+ * @pre 0 <= word < WORDS
+ * @post return mask with one bit set
+ * @param hash hash of the key
+ * @param word word of the block
+ * @return uint64_t bit mask
+ */
+template <class ItemType>
+inline uint64_t BloomFilter<ItemType>::bitOf(uint64_t hash, int word) {
+  // Odd multipliers turn the low half of the hash into a different bit
+  // position for every word
+  static const uint32_t SALTS[WORDS] = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU,
+                                        0xa2b7289dU, 0x705495c7U, 0x2df1424bU,
+                                        0x9efc4947U, 0x5c6bfb31U};
+  return 1ULL << (((uint32_t)hash * SALTS[word]) >> 26);
+}
+
+/**
+ * @brief Get block picked by a hash
+ *
+ * @pre filter has blocks
+ * @post return block of the key
+ * @param hash hash of the key
+ * @return size_t block index
+ */
+template <class ItemType>
+inline size_t BloomFilter<ItemType>::blockOf(uint64_t hash) const {
+  // Scale the high half of the hash to the number of blocks, which needs
+  // no division and no power of two size
+  return (size_t)(((hash >> 32) * (uint64_t)blocks.size()) >> 32);
+}
+
+/**
+ * @brief Empty the filter and size it for a number of keys
+ *
+ * @pre bitsPerKey > 0
+ * @post filter holds no keys and has room for keys
+ * @param keys number of keys expected
+ * @param bitsPerKey bits of filter per key
+ */
+template <class ItemType>
+void BloomFilter<ItemType>::reset(size_t keys, int bitsPerKey) {
+  const size_t bits = keys * (size_t)bitsPerKey;
+  const size_t size = max((size_t)1, (bits + 8 * sizeof(Block) - 1) /
+                                         (8 * sizeof(Block)));
+  blocks.assign(size, Block{});
+}
+
+/**
+ * @brief Add a key
+ *
+ * @pre filter was reset
+ * @post mayContain(key) is true
+ * @param key key to add
+ */
+template <class ItemType> void BloomFilter<ItemType>::add(const ItemType &key) {
+  const uint64_t hash = hashOf(key);
+  Block &block = blocks[blockOf(hash)];
+  for (int word = 0; word < WORDS; word++) {
+    block.words[word] |= bitOf(hash, word);
+  }
+}
+
+/**
+ * @brief Checks if a key may have been added
+ *
+ * @pre none
+ * @post returns false only if key was never added
+ * @param key key to look for
+ * @return bool true if key may be present
+ */
+template <class ItemType>
+bool BloomFilter<ItemType>::mayContain(const ItemType &key) const {
+  if (blocks.empty()) {
+    return false;
+  }
+  const uint64_t hash = hashOf(key);
+  const Block &block = blocks[blockOf(hash)];
+  // Check every word without an early exit, the loop has no branches
+  uint64_t missing = 0;
+  for (int word = 0; word < WORDS; word++) {
+    const uint64_t bit = bitOf(hash, word);
+    missing |= bit & ~block.words[word];
+  }
+  return missing == 0;
+}
+
+/**
+ * @brief Get size of the bit array
+ *
+ * @pre none
+ * @post return bytes used by blocks
+ * @return size_t bytes
+ */
+template <class ItemType> size_t BloomFilter<ItemType>::sizeInBytes() const {
+  return blocks.size() * sizeof(Block);
+}
@@ -0,0 +1,113 @@
+/**
+ * @file BloomFilter.h
+ * @brief BloomFilter header that declares BloomFilter class.
+ *        A blocked Bloom filter. Each key sets one bit in each of the
+ *        eight 64 bit words of a single 64 byte block, so adding or
+ *        checking a key touches one cache line. With 10 bits per key about
+ *        1% of missing keys are reported as maybe present. Keys cannot be
+ *        removed, the owner rebuilds the filter instead.
+ * @author William Susanto and Robel Messele
+ */
+#ifndef BLOOM_FILTER_
+#define BLOOM_FILTER_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+using namespace std;
+
+template <class ItemType> class BloomFilter {
+public:
+  static const int WORDS = 8; // Words per block, one bit is set in each
+
+private:
+  struct alignas(64) Block {
+    uint64_t words[WORDS]; // One cache line of bits
+  };
+
+  vector<Block> blocks; // Bit array, empty holds no keys
+
+  /**
+   * @brief Hash a key
+   *
+   * @pre none
+   * @post return well mixed 64 bit hash
+   * @param key key to hash
+   * @return uint64_t hash
+   */
+  static uint64_t hashOf(const ItemType &key);
+
+  /**
+   * @brief Get bit of a word picked by a hash
+   *
+   * @pre 0 <= word < WORDS
+   * @post return mask with one bit set
+   * @param hash hash of the key
+   * @param word word of the block
+   * @return uint64_t bit mask
+   */
+  static uint64_t bitOf(uint64_t hash, int word);
+
+  /**
+   * @brief Get block picked by a hash
+   *
+   * @pre filter has blocks
+   * @post return block of the key
+   * @param hash hash of the key
+   * @return size_t block index
+   */
+  size_t blockOf(uint64_t hash) const;
+
+public:
+  /**
+   * @brief Constructor
+   *
+   * @pre none
+   * @post empty filter with no blocks
+   */
+  BloomFilter() = default;
+
+  /**
+   * @brief Empty the filter and size it for a number of keys
+   *
+   * @pre bitsPerKey > 0
+   * @post filter holds no keys and has room for keys
+   * @param keys number of keys expected
+   * @param bitsPerKey bits of filter per key
+   */
+  void reset(size_t keys, int bitsPerKey);
+
+  /**
+   * @brief Add a key
+   *
+   * @pre filter was reset
+   * @post mayContain(key) is true
+   * @param key key to add
+   */
+  void add(const ItemType &key);
+
+  /**
+   * @brief Checks if a key may have been added
+   *
+   * @pre none
+   * @post returns false only if key was never added
+   * @param key key to look for
+   * @return bool true if key may be present
+   */
+  bool mayContain(const ItemType &key) const;
+
+  /**
+   * @brief Get size of the bit array
+   *
+   * @pre none
+   * @post return bytes used by blocks
+   * @return size_t bytes
+   */
+  size_t sizeInBytes() const;
+}; // end BloomFilter
+
+#include "BloomFilter.cpp"
+#endif
@@ -0,0 +1,284 @@
+/**
+ * @file MergeIterator.cpp
+ * @brief MergeIterator header that declares MergeIterator class
+ * @author William Susanto and Robel Messele
+ */
+#include "MergeIterator.h"
+
+/**
+ * @brief Checks if one input's head comes before another's
+ *
+ * @pre none
+ * @post returns if a wins, missing and exhausted inputs lose to the
+ *       others and ties go to the lower input
+ * @param a first input
+ * @param b second input
+ * @return bool true if a comes first
+ */
+template <class ItemType>
+inline bool MergeIterator<ItemType>::beats(int a, int b) const {
+  // Leaves past the last input count as exhausted
+  const bool aDone = exhausted[a];
+  const bool bDone = exhausted[b];
+  // Among finished inputs the lower one wins, so an unfilled leaf never
+  // becomes the winner
+  if (aDone || bDone) {
+    return bDone && (!aDone || a < b);
+  }
+  if (fronts[a] < fronts[b]) {
+    return true;
+  }
+  return !(fronts[b] < fronts[a]) && a < b;
+}
+
+/**
+ * @brief Read the next keys of an input into its buffer
+ *
+ * @pre buffer of input is used up
+ * @post buffer holds up to BUFFER keys, input is exhausted if none
+ * @param input input to read
+ */
+template <class ItemType> void MergeIterator<ItemType>::refill(int input) {
+  // Walking a run of successors back to back keeps the nodes of one tree
+  // in cache while they are read
+  const int first = input * BUFFER;
+  int slot = first;
+  for (; slot < first + BUFFER && positions[input] != ends[input]; slot++) {
+    buffers[slot] = *positions[input];
+    ++positions[input];
+  }
+  heads[input] = first;
+  filled[input] = slot;
+  exhausted[input] = slot == first;
+  if (slot != first) {
+    fronts[input] = buffers[first];
+  }
+}
+
+/**
+ * @brief Move an input to its next key
+ *
+ * @pre input is not exhausted
+ * @post head of input is its next key or it is exhausted
+ * @param input input to advance
+ */
+template <class ItemType> void MergeIterator<ItemType>::advance(int input) {
+  if (++heads[input] == filled[input]) {
+    refill(input);
+  } else {
+    fronts[input] = buffers[heads[input]];
+  }
+}
+
+/**
+ * @brief Replays the matches on the path of the winner
+ *
+ * @pre only the head of the winner changed
+ * @post winner is the input with the smallest head
+ */
+template <class ItemType> void MergeIterator<ItemType>::replay() {
+  // Only the matches the old winner played can change result, the new
+  // candidate meets the loser stored at each of them on the way up
+  int candidate = winner;
+  for (int node = (winner + leaves) / 2; node >= 1; node /= 2) {
+    if (beats(losers[node], candidate)) {
+      swap(losers[node], candidate);
+    }
+  }
+  winner = candidate;
+}
+
+/**
+ * @brief Sets up the inputs and plays the first tournament
+ *
+ * @pre ranges lie in trees that stay unchanged
+ * @post iterator at the smallest key of all ranges
+ * @param ranges inputs to merge
+ */
+template <class ItemType>
+void MergeIterator<ItemType>::start(const vector<Range> &ranges) {
+  const int inputs = (int)ranges.size();
+  positions.reserve(inputs);
+  ends.reserve(inputs);
+  if (inputs == 0) {
+    return;
+  }
+  leaves = 1;
+  while (leaves < inputs) {
+    leaves *= 2;
+  }
+  buffers.resize((size_t)inputs * BUFFER);
+  heads.resize(inputs);
+  filled.resize(inputs);
+  fronts.resize(leaves);
+  exhausted.assign(leaves, 1);
+  for (int i = 0; i < inputs; i++) {
+    positions.push_back(ranges[i].first);
+    ends.push_back(ranges[i].second);
+    refill(i);
+  }
+
+  // Play every match bottom up. Leaf i sits at node leaves + i, each
+  // match keeps its loser and sends its winner up.
+  losers.assign(leaves, -1);
+  vector<int> winners(2 * leaves);
+  for (int i = 0; i < leaves; i++) {
+    winners[leaves + i] = i;
+  }
+  for (int node = leaves - 1; node >= 1; node--) {
+    const int a = winners[2 * node];
+    const int b = winners[2 * node + 1];
+    const bool aWins = beats(a, b);
+    winners[node] = aWins ? a : b;
+    losers[node] = aWins ? b : a;
+  }
+  winner = winners[1];
+  if (exhausted[winner]) {
+    winner = -1;
+  }
+}
+
+/**
+ * @brief Merge whole trees
+ *
+ * @pre no tree is nullptr
+ * @post iterator at the smallest key of all trees
+ * @param trees trees to merge
+ * @param skipEqual true to yield each distinct key once
+ */
+template <class ItemType>
+MergeIterator<ItemType>::MergeIterator(
+    const vector<const ThreadedBST<ItemType> *> &trees, bool skipEqual) {
+  unique = skipEqual;
+  vector<Range> ranges;
+  ranges.reserve(trees.size());
+  for (const ThreadedBST<ItemType> *tree : trees) {
+    ranges.emplace_back(tree->begin(), tree->end());
+  }
+  start(ranges);
+}
+
+/**
+ * @brief Merge the keys k with low <= k < high of every tree
+ *
+ * @pre no tree is nullptr
+ * @post iterator at the smallest key of all ranges
+ * @param trees trees to merge
+ * @param low smallest key of the range
+ * @param high key just past the range
+ * @param skipEqual true to yield each distinct key once
+ */
+template <class ItemType>
+MergeIterator<ItemType>::MergeIterator(
+    const vector<const ThreadedBST<ItemType> *> &trees, const ItemType &low,
+    const ItemType &high, bool skipEqual) {
+  unique = skipEqual;
+  vector<Range> ranges;
+  ranges.reserve(trees.size());
+  for (const ThreadedBST<ItemType> *tree : trees) {
+    TreeIterator first(tree, tree->lowerBound(low));
+    // An empty or reversed range stops where it starts
+    TreeIterator last =
+        (low < high) ? TreeIterator(tree, tree->lowerBound(high)) : first;
+    ranges.emplace_back(first, last);
+  }
+  start(ranges);
+}
+
+/**
+ * @brief Merge iterator ranges
+ *
+ * @pre each range is [first, last) of one tree
+ * @post iterator at the smallest key of all ranges
+ * @param ranges inputs to merge
+ * @param skipEqual true to yield each distinct key once
+ */
+template <class ItemType>
+MergeIterator<ItemType>::MergeIterator(const vector<Range> &ranges,
+                                       bool skipEqual) {
+  unique = skipEqual;
+  start(ranges);
+}
+
+/**
+ * @brief Get key at this position
+ *
+ * @pre not the end iterator
+ * @post return smallest key not yet yielded
+ * @return const ItemType& key
+ */
+template <class ItemType>
+const ItemType &MergeIterator<ItemType>::operator*() const {
+  return fronts[winner];
+}
+
+/**
+ * @brief Move to the next key
+ *
+ * @pre not the end iterator
+ * @post iterator at the next key in sorted order or end
+ * @return MergeIterator& this iterator
+ */
+template <class ItemType>
+MergeIterator<ItemType> &MergeIterator<ItemType>::operator++() {
+  const ItemType previous = fronts[winner];
+  do {
+    advance(winner);
+    replay();
+    if (exhausted[winner]) {
+      winner = -1;
+      break;
+    }
+  } while (unique && !(previous < fronts[winner]));
+  return *this;
+}
+
+/**
+ * @brief Move to the next key
+ *
+ * @pre not the end iterator
+ * @post iterator at the next key in sorted order or end
+ * @return MergeIterator iterator before moving
+ */
+template <class ItemType>
+MergeIterator<ItemType> MergeIterator<ItemType>::operator++(int) {
+  MergeIterator<ItemType> before = *this;
+  ++(*this);
+  return before;
+}
+
+/**
+ * @brief Compare positions
+ *
+ * @pre none
+ * @post return true if both are at end, or both are at the same key
+ *       read from the same place of the same input
+ * @param other iterator to compare with
+ * @return bool true if equal
+ */
+template <class ItemType>
+bool MergeIterator<ItemType>::operator==(
+    const MergeIterator<ItemType> &other) const {
+  if (winner < 0 || other.winner < 0) {
+    return winner < 0 && other.winner < 0;
+  }
+  // Equal keys of one input are told apart by where they were read
+  return winner == other.winner && heads[winner] == other.heads[winner] &&
+         positions[winner] == other.positions[winner] &&
+         !(fronts[winner] < other.fronts[winner]) &&
+         !(other.fronts[winner] < fronts[winner]);
+}
+
+/**
+ * @brief Compare positions
+ *
+ * @pre none
+ * @post return negation of ==
+ * @param other iterator to compare with
+ * @return bool true if not equal
+ */
+template <class ItemType>
+bool MergeIterator<ItemType>::operator!=(
+    const MergeIterator<ItemType> &other) const {
+  return !(*this == other);
+}
@@ -0,0 +1,197 @@
+/**
+ * @file MergeIterator.h
+ * @brief MergeIterator header that declares MergeIterator class.
+ *        Merges the keys of many ThreadedBSTs, or of ranges of them, into
+ *        one sorted stream that is produced lazily. Each input walks its
+ *        successor threads BUFFER keys at a time into a small buffer, so
+ *        a tree is read in short runs instead of one node per turn. A
+ *        loser tree picks the smallest head, so each key costs
+ *        log2(inputs) comparisons on arrays that stay in cache. With
+ *        unique set, keys equal to the one before are skipped.
+ *          MergeIterator<int> merged(trees, true);
+ *          for (; merged != MergeIterator<int>(); ++merged) { ... }
+ *        An iterator stays valid while none of its trees change.
+ * @author William Susanto and Robel Messele
+ */
+#ifndef MERGE_ITERATOR_
+#define MERGE_ITERATOR_
+
+#include "ThreadedBST.h"
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+template <class ItemType> class MergeIterator {
+public:
+  typedef ThreadedBSTIterator<ItemType> TreeIterator;
+  typedef pair<TreeIterator, TreeIterator> Range;
+
+  // Keys read ahead from each input
+  static const int BUFFER = 32;
+
+  typedef std::input_iterator_tag iterator_category;
+  typedef ItemType value_type;
+  typedef std::ptrdiff_t difference_type;
+  typedef const ItemType *pointer;
+  typedef const ItemType &reference;
+
+private:
+  vector<TreeIterator> positions; // Next key of each input to buffer
+  vector<TreeIterator> ends;      // End of each input
+  vector<ItemType> buffers;       // BUFFER keys read ahead per input
+  vector<int> heads;              // Buffer slot of each input's smallest key
+  vector<int> filled;             // Slots past the last buffered key
+  vector<ItemType> fronts;        // Copy of each input's smallest key
+  vector<char> exhausted;         // 1 once an input has no keys left,
+                                  // and for leaves past the last input
+  vector<int> losers;             // Loser of each match, node 1 is the
+                                  // final, children of i are 2i and 2i + 1
+  int leaves = 0;                 // Inputs rounded up to a power of two
+  int winner = -1;                // Input holding the smallest key
+  bool unique = false;            // Skip keys equal to the one before
+
+  /**
+   * @brief Checks if one input's head comes before another's
+   *
+   * @pre none
+   * @post returns if a wins, missing and exhausted inputs lose to the
+   *       others and ties go to the lower input
+   * @param a first input
+   * @param b second input
+   * @return bool true if a comes first
+   */
+  bool beats(int a, int b) const;
+
+  /**
+   * @brief Read the next keys of an input into its buffer
+   *
+   * @pre buffer of input is used up
+   * @post buffer holds up to BUFFER keys, input is exhausted if none
+   * @param input input to read
+   */
+  void refill(int input);
+
+  /**
+   * @brief Move an input to its next key
+   *
+   * @pre input is not exhausted
+   * @post head of input is its next key or it is exhausted
+   * @param input input to advance
+   */
+  void advance(int input);
+
+  /**
+   * @brief Replays the matches on the path of the winner
+   *
+   * @pre only the head of the winner changed
+   * @post winner is the input with the smallest head
+   */
+  void replay();
+
+  /**
+   * @brief Sets up the inputs and plays the first tournament
+   *
+   * @pre ranges lie in trees that stay unchanged
+   * @post iterator at the smallest key of all ranges
+   * @param ranges inputs to merge
+   */
+  void start(const vector<Range> &ranges);
+
+public:
+  /**
+   * @brief Constructor
+   *
+   * @pre none
+   * @post end iterator
+   */
+  MergeIterator() = default;
+
+  /**
+   * @brief Merge whole trees
+   *
+   * @pre no tree is nullptr
+   * @post iterator at the smallest key of all trees
+   * @param trees trees to merge
+   * @param skipEqual true to yield each distinct key once
+   */
+  explicit MergeIterator(const vector<const ThreadedBST<ItemType> *> &trees,
+                         bool skipEqual = false);
+
+  /**
+   * @brief Merge the keys k with low <= k < high of every tree
+   *
+   * @pre no tree is nullptr
+   * @post iterator at the smallest key of all ranges
+   * @param trees trees to merge
+   * @param low smallest key of the range
+   * @param high key just past the range
+   * @param skipEqual true to yield each distinct key once
+   */
+  MergeIterator(const vector<const ThreadedBST<ItemType> *> &trees,
+                const ItemType &low, const ItemType &high,
+                bool skipEqual = false);
+
+  /**
+   * @brief Merge iterator ranges
+   *
+   * @pre each range is [first, last) of one tree
+   * @post iterator at the smallest key of all ranges
+   * @param ranges inputs to merge
+   * @param skipEqual true to yield each distinct key once
+   */
+  explicit MergeIterator(const vector<Range> &ranges, bool skipEqual = false);
+
+  /**
+   * @brief Get key at this position
+   *
+   * @pre not the end iterator
+   * @post return smallest key not yet yielded
+   * @return const ItemType& key
+   */
+  const ItemType &operator*() const;
+
+  /**
+   * @brief Move to the next key
+   *
+   * @pre not the end iterator
+   * @post iterator at the next key in sorted order or end
+   * @return MergeIterator& this iterator
+   */
+  MergeIterator<ItemType> &operator++();
+
+  /**
+   * @brief Move to the next key
+   *
+   * @pre not the end iterator
+   * @post iterator at the next key in sorted order or end
+   * @return MergeIterator iterator before moving
+   */
+  MergeIterator<ItemType> operator++(int);
+
+  /**
+   * @brief Compare positions
+   *
+   * @pre none
+   * @post return true if both are at end, or both are at the same key
+   *       read from the same place of the same input
+   * @param other iterator to compare with
+   * @return bool true if equal
+   */
+  bool operator==(const MergeIterator<ItemType> &other) const;
+
+  /**
+   * @brief Compare positions
+   *
+   * @pre none
+   * @post return negation of ==
+   * @param other iterator to compare with
+   * @return bool true if not equal
+   */
+  bool operator!=(const MergeIterator<ItemType> &other) const;
+}; // end MergeIterator
+
+#include "MergeIterator.cpp"
+#endif
@@ -0,0 +1,550 @@
+/**
+ * @file PersistentBST.cpp
+ * @brief PersistentBST header that declares PersistentBST class
+ * @author William Susanto and Robel Messele
+ */
+#include "PersistentBST.h"
+
+/**
+ * @brief Get treap priority of a key
+ *
+ * @pre none
+ * @post return well mixed hash of key
+ * @param key key to hash
+ * @return uint64_t priority
+ */
+template <class ItemType>
+uint64_t PersistentBST<ItemType>::priorityOf(const ItemType &key) {
+  // MurmurHash3 mixer, std::hash of an integer is often the integer
+  uint64_t hash = (uint64_t)std::hash<ItemType>()(key);
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+/**
+ * @brief Take another reference to a node
+ *
+ * @pre none
+ * @post node has one more reference
+ * @param node node to hold, may be nullptr
+ * @return PersistentNode* node
+ */
+template <class ItemType>
+typename PersistentBST<ItemType>::PersistentNode *
+PersistentBST<ItemType>::retain(PersistentNode *node) {
+  if (node != nullptr) {
+    node->references.fetch_add(1, memory_order_relaxed);
+  }
+  return node;
+}
+
+/**
+ * @brief Drop a reference to a node
+ *
+ * @pre caller held a reference to node
+ * @post nodes no version holds any more are deleted
+ * @param node node to let go, may be nullptr
+ */
+template <class ItemType>
+void PersistentBST<ItemType>::release(PersistentNode *node) {
+  // Loop instead of recursing, the subtrees freed can be large
+  vector<PersistentNode *> pending;
+  while (node != nullptr || !pending.empty()) {
+    if (node == nullptr) {
+      node = pending.back();
+      pending.pop_back();
+    }
+    // Another version still holds the node and so its subtrees
+    if (node->references.fetch_sub(1, memory_order_acq_rel) != 1) {
+      node = nullptr;
+      continue;
+    }
+    if (node->right != nullptr) {
+      pending.push_back(node->right);
+    }
+    PersistentNode *left = node->left;
+    delete node;
+    node = left;
+  }
+}
+
+/**
+ * @brief Get a node this version may change
+ *
+ * @pre caller held a reference to node
+ * @post returns node if only the caller held it, otherwise a copy
+ *       sharing its children, with the reference moved to the copy
+ * @param node node about to change
+ * @return PersistentNode* node held by the caller alone
+ */
+template <class ItemType>
+typename PersistentBST<ItemType>::PersistentNode *
+PersistentBST<ItemType>::unshare(PersistentNode *node) {
+  // No other version can reach the node, so change it in place
+  if (node->references.load(memory_order_acquire) == 1) {
+    return node;
+  }
+  PersistentNode *copy =
+      new PersistentNode{node->item, retain(node->left), retain(node->right),
+                         node->occurrences, node->priority};
+  release(node);
+  return copy;
+}
+
+/**
+ * @brief Adds a copy of a key to a subtree
+ *
+ * @pre caller held a reference to node
+ * @post returns root of subtree holding key, nodes on the path are
+ *       unshared
+ * @param node subtree root
+ * @param key key to add
+ * @param added set true if a node was made
+ * @return PersistentNode* new subtree root
+ */
+template <class ItemType>
+typename PersistentBST<ItemType>::PersistentNode *
+PersistentBST<ItemType>::addAt(PersistentNode *node, const ItemType &key,
+                               bool &added) {
+  if (node == nullptr) {
+    added = true;
+    return new PersistentNode{key, nullptr, nullptr, 1, priorityOf(key)};
+  }
+  node = unshare(node);
+  // The child returned is unshared too, so rotating it above node only
+  // moves references between nodes this version owns
+  if (key < node->item) {
+    node->left = addAt(node->left, key, added);
+    if (node->left->priority > node->priority) {
+      PersistentNode *child = node->left;
+      node->left = child->right;
+      child->right = node;
+      return child;
+    }
+  } else if (node->item < key) {
+    node->right = addAt(node->right, key, added);
+    if (node->right->priority > node->priority) {
+      PersistentNode *child = node->right;
+      node->right = child->left;
+      child->left = node;
+      return child;
+    }
+  } else {
+    node->occurrences++;
+  }
+  return node;
+}
+
+/**
+ * @brief Takes copies of a key from a subtree
+ *
+ * @pre caller held a reference to node, key is in the subtree
+ * @post returns root of subtree with copies fewer, at most all of them
+ * @param node subtree root
+ * @param key key to remove
+ * @param copies most copies to take
+ * @param removed set to copies taken
+ * @param unlinked set true if the node of key was removed
+ * @return PersistentNode* new subtree root
+ */
+template <class ItemType>
+typename PersistentBST<ItemType>::PersistentNode *
+PersistentBST<ItemType>::removeAt(PersistentNode *node, const ItemType &key,
+                                  int copies, int &removed, bool &unlinked) {
+  node = unshare(node);
+  if (key < node->item) {
+    node->left = removeAt(node->left, key, copies, removed, unlinked);
+  } else if (node->item < key) {
+    node->right = removeAt(node->right, key, copies, removed, unlinked);
+  } else {
+    removed = min(copies, node->occurrences);
+    node->occurrences -= removed;
+    if (node->occurrences == 0) {
+      // Hand the children to the merge and free the node alone
+      unlinked = true;
+      PersistentNode *lower = node->left;
+      PersistentNode *upper = node->right;
+      node->left = nullptr;
+      node->right = nullptr;
+      release(node);
+      return merge(lower, upper);
+    }
+  }
+  return node;
+}
+
+/**
+ * @brief Merges two treaps
+ *
+ * @pre every key of lower < every key of upper, caller held both
+ * @post returns root of treap holding both
+ * @param lower treap with smaller keys
+ * @param upper treap with larger keys
+ * @return PersistentNode* merged root
+ */
+template <class ItemType>
+typename PersistentBST<ItemType>::PersistentNode *
+PersistentBST<ItemType>::merge(PersistentNode *lower, PersistentNode *upper) {
+  if (lower == nullptr) {
+    return upper;
+  }
+  if (upper == nullptr) {
+    return lower;
+  }
+  // Higher priority becomes the root, only the right spine of lower and
+  // the left spine of upper are copied
+  if (lower->priority > upper->priority) {
+    lower = unshare(lower);
+    lower->right = merge(lower->right, upper);
+    return lower;
+  }
+  upper = unshare(upper);
+  upper->left = merge(lower, upper->left);
+  return upper;
+}
+
+/**
+ * @brief Find the node of a key
+ *
+ * @pre none
+ * @post returns node with key or nullptr
+ * @param key key to look for
+ * @return const PersistentNode* node with key
+ */
+template <class ItemType>
+const typename PersistentBST<ItemType>::PersistentNode *
+PersistentBST<ItemType>::findNode(const ItemType &key) const {
+  const PersistentNode *node = rootPtr;
+  while (node != nullptr) {
+    if (key < node->item) {
+      node = node->left;
+    } else if (node->item < key) {
+      node = node->right;
+    } else {
+      return node;
+    }
+  }
+  return nullptr;
+}
+
+/**
+ * @brief Push a node and its chain of left children
+ *
+ * @pre none
+ * @post top of path is the smallest node of the subtree
+ * @param node subtree root, may be nullptr
+ */
+template <class ItemType>
+void PersistentBST<ItemType>::iterator::pushLeft(const PersistentNode *node) {
+  while (node != nullptr) {
+    path.push_back(node);
+    node = node->left;
+  }
+}
+
+/**
+ * @brief Get item at this position
+ *
+ * @pre not the end iterator
+ * @post return node item
+ * @return const ItemType& node item
+ */
+template <class ItemType>
+const ItemType &PersistentBST<ItemType>::iterator::operator*() const {
+  return path.back()->item;
+}
+
+/**
+ * @brief Move to inorder successor
+ *
+ * @pre not the end iterator
+ * @post iterator at next copy, successor or end
+ * @return iterator& this iterator
+ */
+template <class ItemType>
+typename PersistentBST<ItemType>::iterator &
+PersistentBST<ItemType>::iterator::operator++() {
+  const PersistentNode *node = path.back();
+  if (++copy < node->occurrences) {
+    return *this;
+  }
+  copy = 0;
+  // Successor is the leftmost node of the right subtree, or else the
+  // nearest ancestor still on the stack
+  path.pop_back();
+  pushLeft(node->right);
+  return *this;
+}
+
+/**
+ * @brief Compare positions
+ *
+ * @pre none
+ * @post return if both are at the same copy of the same node
+ * @param other iterator to compare with
+ * @return bool true if equal
+ */
+template <class ItemType>
+bool PersistentBST<ItemType>::iterator::operator==(
+    const iterator &other) const {
+  if (path.empty() || other.path.empty()) {
+    return path.empty() == other.path.empty();
+  }
+  return path.back() == other.path.back() && copy == other.copy;
+}
+
+/**
+ * @brief Compare positions
+ *
+ * @pre none
+ * @post return if iterators are at different nodes or copies
+ * @param other iterator to compare with
+ * @return bool true if not equal
+ */
+template <class ItemType>
+bool PersistentBST<ItemType>::iterator::operator!=(
+    const iterator &other) const {
+  return !(*this == other);
+}
+
+/**
+ * @brief Copy constructor, O(1)
+ *
+ * @pre none
+ * @post tree shares every node of tree
+ * @param tree version to share
+ */
+template <class ItemType>
+PersistentBST<ItemType>::PersistentBST(const PersistentBST<ItemType> &tree) {
+  rootPtr = retain(tree.rootPtr);
+  count = tree.count;
+}
+
+/**
+ * @brief Move constructor
+ *
+ * @pre none
+ * @post tree holds the nodes of other, other is empty
+ * @param tree version to take over
+ */
+template <class ItemType>
+PersistentBST<ItemType>::PersistentBST(
+    PersistentBST<ItemType> &&tree) noexcept {
+  rootPtr = tree.rootPtr;
+  count = tree.count;
+  tree.rootPtr = nullptr;
+  tree.count = 0;
+}
+
+/**
+ * @brief Assignment, O(1)
+ *
+ * @pre none
+ * @post tree shares every node of tree, its old nodes are let go
+ * @param tree version to share
+ * @return PersistentBST& this tree
+ */
+template <class ItemType>
+PersistentBST<ItemType> &
+PersistentBST<ItemType>::operator=(const PersistentBST<ItemType> &tree) {
+  // Hold the new root first so assigning a tree to itself keeps it
+  PersistentNode *old = rootPtr;
+  rootPtr = retain(tree.rootPtr);
+  count = tree.count;
+  release(old);
+  return *this;
+}
+
+/**
+ * @brief Move assignment
+ *
+ * @pre none
+ * @post tree holds the nodes of other, other is empty
+ * @param tree version to take over
+ * @return PersistentBST& this tree
+ */
+template <class ItemType>
+PersistentBST<ItemType> &
+PersistentBST<ItemType>::operator=(PersistentBST<ItemType> &&tree) noexcept {
+  if (&tree != this) {
+    release(rootPtr);
+    rootPtr = tree.rootPtr;
+    count = tree.count;
+    tree.rootPtr = nullptr;
+    tree.count = 0;
+  }
+  return *this;
+}
+
+/**
+ * @brief Destructor
+ *
+ * @pre none
+ * @post nodes no other version holds are deleted
+ */
+template <class ItemType> PersistentBST<ItemType>::~PersistentBST() {
+  release(rootPtr);
+}
+
+/**
+ * @brief Get a point in time copy, O(1)
+ *
+ * @pre none
+ * @post returns version that later changes to this tree do not affect
+ * @return PersistentBST version sharing every node
+ */
+template <class ItemType>
+PersistentBST<ItemType> PersistentBST<ItemType>::snapshot() const {
+  return PersistentBST<ItemType>(*this);
+}
+
+/**
+ * @brief Get number of nodes
+ *
+ * @pre none
+ * @post return distinct keys
+ * @return int number of nodes
+ */
+template <class ItemType> int PersistentBST<ItemType>::size() const {
+  return count;
+}
+
+/**
+ * @brief Adds a copy of a key
+ *
+ * @pre none
+ * @post key is counted once more, shared nodes on its path are copied
+ * @param key key to add
+ */
+template <class ItemType>
+void PersistentBST<ItemType>::add(const ItemType &key) {
+  bool added = false;
+  rootPtr = addAt(rootPtr, key, added);
+  count += added;
+}
+
+/**
+ * @brief Removes one copy of a key
+ *
+ * @pre none
+ * @post one copy is removed if key exists
+ * @param key key to remove
+ * @return bool true if a copy was removed
+ */
+template <class ItemType>
+bool PersistentBST<ItemType>::remove(const ItemType &key) {
+  // Search first so a missing key copies nothing
+  if (findNode(key) == nullptr) {
+    return false;
+  }
+  int removed = 0;
+  bool unlinked = false;
+  rootPtr = removeAt(rootPtr, key, 1, removed, unlinked);
+  count -= unlinked;
+  return true;
+}
+
+/**
+ * @brief Removes every copy of a key
+ *
+ * @pre none
+ * @post key is not in tree
+ * @param key key to remove
+ * @return int number of removed copies
+ */
+template <class ItemType>
+int PersistentBST<ItemType>::erase(const ItemType &key) {
+  const PersistentNode *node = findNode(key);
+  if (node == nullptr) {
+    return 0;
+  }
+  int removed = 0;
+  bool unlinked = false;
+  rootPtr = removeAt(rootPtr, key, node->occurrences, removed, unlinked);
+  count -= unlinked;
+  return removed;
+}
+
+/**
+ * @brief Checks if a key exists
+ *
+ * @pre none
+ * @post returns if key is in tree
+ * @param key key to look for
+ * @return bool true if found
+ */
+template <class ItemType>
+bool PersistentBST<ItemType>::contains(const ItemType &key) const {
+  return findNode(key) != nullptr;
+}
+
+/**
+ * @brief Get number of copies of a key
+ *
+ * @pre none
+ * @post returns copies of key in tree
+ * @param key key to look for
+ * @return int number of copies
+ */
+template <class ItemType>
+int PersistentBST<ItemType>::countOf(const ItemType &key) const {
+  const PersistentNode *node = findNode(key);
+  return node == nullptr ? 0 : node->occurrences;
+}
+
+/**
+ * @brief Get iterator to the first key not less than given key
+ *
+ * @pre none
+ * @post returns iterator to lower bound or end()
+ * @param key key to look for
+ * @return iterator lower bound position
+ */
+template <class ItemType>
+typename PersistentBST<ItemType>::iterator
+PersistentBST<ItemType>::lowerBound(const ItemType &key) const {
+  // Keep the nodes the search passed on the left, they come next in order
+  iterator position;
+  const PersistentNode *node = rootPtr;
+  while (node != nullptr) {
+    if (node->item < key) {
+      node = node->right;
+    } else {
+      position.path.push_back(node);
+      node = node->left;
+    }
+  }
+  return position;
+}
+
+/**
+ * @brief Get iterator to the smallest key
+ *
+ * @pre none
+ * @post returns iterator to leftmost node
+ * @return iterator first position
+ */
+template <class ItemType>
+typename PersistentBST<ItemType>::iterator
+PersistentBST<ItemType>::begin() const {
+  iterator position;
+  position.pushLeft(rootPtr);
+  return position;
+}
+
+/**
+ * @brief Get iterator past the largest key
+ *
+ * @pre none
+ * @post returns end iterator
+ * @return iterator end position
+ */
+template <class ItemType>
+typename PersistentBST<ItemType>::iterator
+PersistentBST<ItemType>::end() const {
+  return iterator();
+}
@@ -0,0 +1,366 @@
+/**
+ * @file PersistentBST.h
+ * @brief PersistentBST header that declares PersistentBST class.
+ *        A persistent BST whose versions share nodes. Copying a tree or
+ *        calling snapshot() is O(1): the copy holds another reference to
+ *        the same root. A change copies only the nodes on the path it
+ *        walks that another version still holds, and a node is deleted
+ *        when the last version holding it lets go.
+ *        Nodes cannot carry threads, since one shared node would need a
+ *        different successor in every version it belongs to. Iterators
+ *        keep the path from the root on a stack instead. A step is O(1)
+ *        amortized and O(log n) at worst, against one pointer follow in
+ *        a ThreadedBST, and the iterator holds O(log n) pointers.
+ *        Keys are kept balanced as a treap ordered by a hash of the key,
+ *        so a set of keys has the same shape whatever order it was built
+ *        in. Equal keys share a node that counts them.
+ *        Reference counts are atomic, so versions may be used by different
+ *        threads, one thread per version at a time.
+ * @author William Susanto and Robel Messele
+ */
+#ifndef PERSISTENT_BST_
+#define PERSISTENT_BST_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <vector>
+
+using namespace std;
+
+template <class ItemType> class PersistentBST {
+private:
+  struct PersistentNode {
+    ItemType item;                    // Data portion
+    PersistentNode *left = nullptr;   // Left child
+    PersistentNode *right = nullptr;  // Right child
+    int occurrences = 1;              // Copies of item
+    uint64_t priority = 0;            // Heap order of the treap
+    atomic<int> references{1};        // Versions and parents holding it
+  };
+
+  PersistentNode *rootPtr = nullptr; // Root held by this version
+  int count = 0;                     // Number of nodes
+
+  /**
+   * @brief Get treap priority of a key
+   *
+   * @pre none
+   * @post return well mixed hash of key
+   * @param key key to hash
+   * @return uint64_t priority
+   */
+  static uint64_t priorityOf(const ItemType &key);
+
+  /**
+   * @brief Take another reference to a node
+   *
+   * @pre none
+   * @post node has one more reference
+   * @param node node to hold, may be nullptr
+   * @return PersistentNode* node
+   */
+  static PersistentNode *retain(PersistentNode *node);
+
+  /**
+   * @brief Drop a reference to a node
+   *
+   * @pre caller held a reference to node
+   * @post nodes no version holds any more are deleted
+   * @param node node to let go, may be nullptr
+   */
+  static void release(PersistentNode *node);
+
+  /**
+   * @brief Get a node this version may change
+   *
+   * @pre caller held a reference to node
+   * @post returns node if only the caller held it, otherwise a copy
+   *       sharing its children, with the reference moved to the copy
+   * @param node node about to change
+   * @return PersistentNode* node held by the caller alone
+   */
+  static PersistentNode *unshare(PersistentNode *node);
+
+  /**
+   * @brief Adds a copy of a key to a subtree
+   *
+   * @pre caller held a reference to node
+   * @post returns root of subtree holding key, nodes on the path are
+   *       unshared
+   * @param node subtree root
+   * @param key key to add
+   * @param added set true if a node was made
+   * @return PersistentNode* new subtree root
+   */
+  static PersistentNode *addAt(PersistentNode *node, const ItemType &key,
+                               bool &added);
+
+  /**
+   * @brief Takes copies of a key from a subtree
+   *
+   * @pre caller held a reference to node, key is in the subtree
+   * @post returns root of subtree with copies fewer, at most all of them
+   * @param node subtree root
+   * @param key key to remove
+   * @param copies most copies to take
+   * @param removed set to copies taken
+   * @param unlinked set true if the node of key was removed
+   * @return PersistentNode* new subtree root
+   */
+  static PersistentNode *removeAt(PersistentNode *node, const ItemType &key,
+                                  int copies, int &removed, bool &unlinked);
+
+  /**
+   * @brief Merges two treaps
+   *
+   * @pre every key of lower < every key of upper, caller held both
+   * @post returns root of treap holding both
+   * @param lower treap with smaller keys
+   * @param upper treap with larger keys
+   * @return PersistentNode* merged root
+   */
+  static PersistentNode *merge(PersistentNode *lower, PersistentNode *upper);
+
+  /**
+   * @brief Find the node of a key
+   *
+   * @pre none
+   * @post returns node with key or nullptr
+   * @param key key to look for
+   * @return const PersistentNode* node with key
+   */
+  const PersistentNode *findNode(const ItemType &key) const;
+
+public:
+  /**
+   * In order iterator over one version. It keeps the ancestors it still
+   * has to visit on a stack, since nodes have no threads. It stays valid
+   * while its version is neither changed nor destroyed.
+   */
+  class iterator {
+  private:
+    vector<const PersistentNode *> path; // Ancestors left to visit, top is
+                                         // the current node
+    int copy = 0;                        // Copy of the node item, from 0
+
+    /**
+     * @brief Push a node and its chain of left children
+     *
+     * @pre none
+     * @post top of path is the smallest node of the subtree
+     * @param node subtree root, may be nullptr
+     */
+    void pushLeft(const PersistentNode *node);
+
+    friend class PersistentBST<ItemType>;
+
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef ItemType value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const ItemType *pointer;
+    typedef const ItemType &reference;
+
+    /**
+     * @brief Constructor
+     *
+     * @pre none
+     * @post end iterator
+     */
+    iterator() = default;
+
+    /**
+     * @brief Get item at this position
+     *
+     * @pre not the end iterator
+     * @post return node item
+     * @return const ItemType& node item
+     */
+    const ItemType &operator*() const;
+
+    /**
+     * @brief Move to inorder successor
+     *
+     * @pre not the end iterator
+     * @post iterator at next copy, successor or end
+     * @return iterator& this iterator
+     */
+    iterator &operator++();
+
+    /**
+     * @brief Compare positions
+     *
+     * @pre none
+     * @post return if both are at the same copy of the same node
+     * @param other iterator to compare with
+     * @return bool true if equal
+     */
+    bool operator==(const iterator &other) const;
+
+    /**
+     * @brief Compare positions
+     *
+     * @pre none
+     * @post return if iterators are at different nodes or copies
+     * @param other iterator to compare with
+     * @return bool true if not equal
+     */
+    bool operator!=(const iterator &other) const;
+  }; // end iterator
+
+  /**
+   * @brief Constructor
+   *
+   * @pre none
+   * @post empty tree
+   */
+  PersistentBST() = default;
+
+  /**
+   * @brief Copy constructor, O(1)
+   *
+   * @pre none
+   * @post tree shares every node of tree
+   * @param tree version to share
+   */
+  PersistentBST(const PersistentBST<ItemType> &tree);
+
+  /**
+   * @brief Move constructor
+   *
+   * @pre none
+   * @post tree holds the nodes of other, other is empty
+   * @param tree version to take over
+   */
+  PersistentBST(PersistentBST<ItemType> &&tree) noexcept;
+
+  /**
+   * @brief Assignment, O(1)
+   *
+   * @pre none
+   * @post tree shares every node of tree, its old nodes are let go
+   * @param tree version to share
+   * @return PersistentBST& this tree
+   */
+  PersistentBST<ItemType> &operator=(const PersistentBST<ItemType> &tree);
+
+  /**
+   * @brief Move assignment
+   *
+   * @pre none
+   * @post tree holds the nodes of other, other is empty
+   * @param tree version to take over
+   * @return PersistentBST& this tree
+   */
+  PersistentBST<ItemType> &operator=(PersistentBST<ItemType> &&tree) noexcept;
+
+  /**
+   * @brief Destructor
+   *
+   * @pre none
+   * @post nodes no other version holds are deleted
+   */
+  ~PersistentBST();
+
+  /**
+   * @brief Get a point in time copy, O(1)
+   *
+   * @pre none
+   * @post returns version that later changes to this tree do not affect
+   * @return PersistentBST version sharing every node
+   */
+  PersistentBST<ItemType> snapshot() const;
+
+  /**
+   * @brief Get number of nodes
+   *
+   * @pre none
+   * @post return distinct keys
+   * @return int number of nodes
+   */
+  int size() const;
+
+  /**
+   * @brief Adds a copy of a key
+   *
+   * @pre none
+   * @post key is counted once more, shared nodes on its path are copied
+   * @param key key to add
+   */
+  void add(const ItemType &key);
+
+  /**
+   * @brief Removes one copy of a key
+   *
+   * @pre none
+   * @post one copy is removed if key exists
+   * @param key key to remove
+   * @return bool true if a copy was removed
+   */
+  bool remove(const ItemType &key);
+
+  /**
+   * @brief Removes every copy of a key
+   *
+   * @pre none
+   * @post key is not in tree
+   * @param key key to remove
+   * @return int number of removed copies
+   */
+  int erase(const ItemType &key);
+
+  /**
+   * @brief Checks if a key exists
+   *
+   * @pre none
+   * @post returns if key is in tree
+   * @param key key to look for
+   * @return bool true if found
+   */
+  bool contains(const ItemType &key) const;
+
+  /**
+   * @brief Get number of copies of a key
+   *
+   * @pre none
+   * @post returns copies of key in tree
+   * @param key key to look for
+   * @return int number of copies
+   */
+  int countOf(const ItemType &key) const;
+
+  /**
+   * @brief Get iterator to the first key not less than given key
+   *
+   * @pre none
+   * @post returns iterator to lower bound or end()
+   * @param key key to look for
+   * @return iterator lower bound position
+   */
+  iterator lowerBound(const ItemType &key) const;
+
+  /**
+   * @brief Get iterator to the smallest key
+   *
+   * @pre none
+   * @post returns iterator to leftmost node
+   * @return iterator first position
+   */
+  iterator begin() const;
+
+  /**
+   * @brief Get iterator past the largest key
+   *
+   * @pre none
+   * @post returns end iterator
+   * @return iterator end position
+   */
+  iterator end() const;
+}; // end PersistentBST
+
+#include "PersistentBST.cpp"
+#endif
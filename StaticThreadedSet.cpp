@@ -0,0 +1,333 @@
+/**
+ * @file StaticThreadedSet.cpp
+ * @brief StaticThreadedSet header that declares StaticThreadedSet class
+ * @author William Susanto and Robel Messele
+ */
+#include "StaticThreadedSet.h"
+
+/**
+ * @brief Number of levels of the tree
+ *
+ * @pre none
+ * @post return bit length of N
+ * @return int levels
+ */
+template <class ItemType, size_t N>
+constexpr int StaticThreadedSet<ItemType, N>::levels() {
+  int count = 0;
+  for (size_t size = N; size > 0; size >>= 1) {
+    count++;
+  }
+  return count;
+}
+
+/**
+ * @brief Takes one search step
+ *
+ * @pre 1 <= slot
+ * @post returns slot of the child toward key, unused slots stay put
+ * @param slot current slot, counting from 1
+ * @param key key to look for
+ * @return size_t next slot
+ */
+template <class ItemType, size_t N>
+constexpr size_t
+StaticThreadedSet<ItemType, N>::step(size_t slot, const ItemType &key) const {
+  // Both selects compile to conditional moves, the comparison picks the
+  // child by arithmetic instead of a branch
+  const bool inside = slot <= used;
+  const ItemType &item = nodes[(inside ? slot : 1) - 1].item;
+  return inside ? 2 * slot + (item < key) : slot;
+}
+
+/**
+ * @brief Takes Level search steps, unrolled at compile time
+ *
+ * @pre 1 <= slot
+ * @post returns slot after Level steps
+ * @param slot current slot, counting from 1
+ * @param key key to look for
+ * @return size_t slot reached
+ */
+template <class ItemType, size_t N>
+template <int Level>
+constexpr size_t
+StaticThreadedSet<ItemType, N>::descend(size_t slot,
+                                        const ItemType &key) const {
+  if constexpr (Level == 0) {
+    return slot;
+  } else {
+    return descend<Level - 1>(step(slot, key), key);
+  }
+}
+
+/**
+ * @brief Get slot of the first key not less than key
+ *
+ * @pre none
+ * @post returns slot counting from 1, 0 if every key is less
+ * @param key key to look for
+ * @return size_t lower bound slot
+ */
+template <class ItemType, size_t N>
+constexpr size_t
+StaticThreadedSet<ItemType, N>::lowerSlot(const ItemType &key) const {
+  // Every path takes levels() steps to run off the tree
+  size_t slot = 1;
+  if constexpr (levels() <= UNROLL_LEVELS) {
+    slot = descend<levels()>(slot, key);
+  } else {
+    for (int level = 0; level < levels(); level++) {
+      slot = step(slot, key);
+    }
+  }
+  // The low bits hold the path, one bit per level with 1 for a right turn.
+  // The lower bound is where the path last turned left, so drop the
+  // trailing right turns and that left turn.
+#if defined(__GNUC__)
+  return slot >> (__builtin_ctzll(~(unsigned long long)slot) + 1);
+#else
+  while (slot & 1) {
+    slot >>= 1;
+  }
+  return slot >> 1;
+#endif
+}
+
+/**
+ * @brief Constructor
+ *
+ * @pre index is a node of owner or -1
+ * @post iterator at index
+ * @param owner set to iterate
+ * @param position node index, -1 for end
+ */
+template <class ItemType, size_t N>
+constexpr StaticThreadedSet<ItemType, N>::iterator::iterator(
+    const StaticThreadedSet<ItemType, N> *owner, int position)
+    : set(owner), index(position) {}
+
+/**
+ * @brief Get item at this position
+ *
+ * @pre not the end iterator
+ * @post return node item
+ * @return const ItemType& node item
+ */
+template <class ItemType, size_t N>
+constexpr const ItemType &
+StaticThreadedSet<ItemType, N>::iterator::operator*() const {
+  return set->nodes[index].item;
+}
+
+/**
+ * @brief Move to inorder successor
+ *
+ * @pre not the end iterator
+ * @post iterator at successor or end
+ * @return iterator& this iterator
+ */
+template <class ItemType, size_t N>
+constexpr typename StaticThreadedSet<ItemType, N>::iterator &
+StaticThreadedSet<ItemType, N>::iterator::operator++() {
+  const StaticNode &node = set->nodes[index];
+  index = node.right;
+  // Thread leads straight to the successor, otherwise it is the leftmost
+  // node of the right subtree
+  if (!node.isThreadedRight && index >= 0) {
+    while (!set->nodes[index].isThreadedLeft && set->nodes[index].left >= 0) {
+      index = set->nodes[index].left;
+    }
+  }
+  return *this;
+}
+
+/**
+ * @brief Move to inorder predecessor
+ *
+ * @pre not the end iterator
+ * @post iterator at predecessor, end if at the smallest node
+ * @return iterator& this iterator
+ */
+template <class ItemType, size_t N>
+constexpr typename StaticThreadedSet<ItemType, N>::iterator &
+StaticThreadedSet<ItemType, N>::iterator::operator--() {
+  const StaticNode &node = set->nodes[index];
+  index = node.left;
+  if (!node.isThreadedLeft && index >= 0) {
+    while (!set->nodes[index].isThreadedRight &&
+           set->nodes[index].right >= 0) {
+      index = set->nodes[index].right;
+    }
+  }
+  return *this;
+}
+
+/**
+ * @brief Compare positions
+ *
+ * @pre none
+ * @post return if both are at the same node
+ * @param other iterator to compare with
+ * @return bool true if equal
+ */
+template <class ItemType, size_t N>
+constexpr bool StaticThreadedSet<ItemType, N>::iterator::operator==(
+    const iterator &other) const {
+  return index == other.index;
+}
+
+/**
+ * @brief Compare positions
+ *
+ * @pre none
+ * @post return if iterators are at different nodes
+ * @param other iterator to compare with
+ * @return bool true if not equal
+ */
+template <class ItemType, size_t N>
+constexpr bool StaticThreadedSet<ItemType, N>::iterator::operator!=(
+    const iterator &other) const {
+  return index != other.index;
+}
+
+/**
+ * @brief Key table constructor
+ *
+ * @pre none, keys may be in any order and may repeat
+ * @post balanced threaded tree holding each distinct key once
+ * @param keys keys of the set
+ */
+template <class ItemType, size_t N>
+constexpr StaticThreadedSet<ItemType, N>::StaticThreadedSet(
+    const ItemType (&keys)[N]) {
+  // Insertion sort, it runs at compile time where the table is small
+  ItemType sorted[N]{};
+  for (size_t i = 0; i < N; i++) {
+    size_t j = i;
+    for (; j > 0 && keys[i] < sorted[j - 1]; j--) {
+      sorted[j] = sorted[j - 1];
+    }
+    sorted[j] = keys[i];
+  }
+  // A set holds each key once, drop the repeats
+  used = 0;
+  for (size_t i = 0; i < N; i++) {
+    if (used == 0 || sorted[used - 1] < sorted[i]) {
+      sorted[used++] = sorted[i];
+    }
+  }
+
+  // Hand the sorted keys to the slots in inorder, starting from the
+  // leftmost slot, and link each slot to its children or threads
+  size_t slot = 1;
+  while (2 * slot <= used) {
+    slot = 2 * slot;
+  }
+  first = (int)slot - 1;
+  size_t prev = 0;
+  for (size_t i = 0; i < used; i++) {
+    StaticNode &node = nodes[slot - 1];
+    node.item = sorted[i];
+    node.left = -1;
+    node.right = -1;
+    node.isThreadedLeft = false;
+    node.isThreadedRight = false;
+    if (2 * slot <= used) {
+      node.left = (int)(2 * slot) - 1;
+    } else if (prev != 0) {
+      node.left = (int)prev - 1;
+      node.isThreadedLeft = true;
+    }
+    if (2 * slot + 1 <= used) {
+      node.right = (int)(2 * slot + 1) - 1;
+    }
+    // Previous slot without a right child threads to this one
+    if (prev != 0 && 2 * prev + 1 > used) {
+      nodes[prev - 1].right = (int)slot - 1;
+      nodes[prev - 1].isThreadedRight = true;
+    }
+    prev = slot;
+
+    // Next slot in inorder is the leftmost of the right subtree, or else
+    // the parent above the last left turn
+    if (2 * slot + 1 <= used) {
+      slot = 2 * slot + 1;
+      while (2 * slot <= used) {
+        slot = 2 * slot;
+      }
+    } else {
+      while (slot & 1) {
+        slot >>= 1;
+      }
+      slot >>= 1;
+    }
+  }
+}
+
+/**
+ * @brief Get number of keys
+ *
+ * @pre none
+ * @post return number of distinct keys, at most N
+ * @return size_t number of keys
+ */
+template <class ItemType, size_t N>
+constexpr size_t StaticThreadedSet<ItemType, N>::size() const {
+  return used;
+}
+
+/**
+ * @brief Checks if key is in the set
+ *
+ * @pre none
+ * @post returns if key is in set
+ * @param key key to look for
+ * @return bool true if found
+ */
+template <class ItemType, size_t N>
+constexpr bool
+StaticThreadedSet<ItemType, N>::contains(const ItemType &key) const {
+  const size_t slot = lowerSlot(key);
+  return slot != 0 && !(key < nodes[slot - 1].item);
+}
+
+/**
+ * @brief Get the first key not less than given key
+ *
+ * @pre none
+ * @post returns iterator to lower bound or end()
+ * @param key key to look for
+ * @return iterator lower bound position
+ */
+template <class ItemType, size_t N>
+constexpr typename StaticThreadedSet<ItemType, N>::iterator
+StaticThreadedSet<ItemType, N>::lowerBound(const ItemType &key) const {
+  return iterator(this, (int)lowerSlot(key) - 1);
+}
+
+/**
+ * @brief Get iterator to the smallest key
+ *
+ * @pre none
+ * @post returns iterator to leftmost node
+ * @return iterator first position
+ */
+template <class ItemType, size_t N>
+constexpr typename StaticThreadedSet<ItemType, N>::iterator
+StaticThreadedSet<ItemType, N>::begin() const {
+  return iterator(this, first);
+}
+
+/**
+ * @brief Get iterator past the largest key
+ *
+ * @pre none
+ * @post returns end iterator
+ * @return iterator end position
+ */
+template <class ItemType, size_t N>
+constexpr typename StaticThreadedSet<ItemType, N>::iterator
+StaticThreadedSet<ItemType, N>::end() const {
+  return iterator(this, -1);
+}
@@ -0,0 +1,221 @@
+/**
+ * @file StaticThreadedSet.h
+ * @brief StaticThreadedSet header that declares StaticThreadedSet class.
+ *        A threaded BST over a fixed key table that is built at compile
+ *        time. The nodes are an array holding a complete tree in breadth
+ *        first order, so children of slot i are slots 2i and 2i + 1
+ *        (counting from 1). Child and thread links are array indices worked
+ *        out by the constexpr constructor, so a constexpr set lives in read
+ *        only data with no startup cost and no heap use:
+ *          static constexpr int table[] = {7, 3, 11, 5};
+ *          static constexpr StaticThreadedSet<int, 4> keys(table);
+ *          static_assert(keys.contains(5));
+ *        Searches take a fixed number of steps with no data dependent
+ *        branches. Up to UNROLL_LEVELS levels the steps are unrolled at
+ *        compile time.
+ * @author William Susanto and Robel Messele
+ */
+#ifndef STATIC_THREADED_SET_
+#define STATIC_THREADED_SET_
+
+#include <cstddef>
+#include <iterator>
+
+using namespace std;
+
+template <class ItemType, size_t N> class StaticThreadedSet {
+  static_assert(N > 0, "StaticThreadedSet needs at least one key");
+
+public:
+  // Trees with at most this many levels are searched without a loop
+  static constexpr int UNROLL_LEVELS = 8;
+
+private:
+  struct StaticNode {
+    ItemType item{};              // Data portion
+    int left = -1;                // Left child or predecessor, -1 if none
+    int right = -1;               // Right child or successor, -1 if none
+    bool isThreadedLeft = false;  // true if left is the inorder predecessor
+    bool isThreadedRight = false; // true if right is the inorder successor
+  };
+
+  StaticNode nodes[N] = {}; // Breadth first slots, slot i + 1 at index i
+  size_t used = N;          // Slots in use, one per distinct key
+  int first = 0;            // Index of the smallest key
+
+  /**
+   * @brief Number of levels of the tree
+   *
+   * @pre none
+   * @post return bit length of N
+   * @return int levels
+   */
+  static constexpr int levels();
+
+  /**
+   * @brief Takes one search step
+   *
+   * @pre 1 <= slot
+   * @post returns slot of the child toward key, unused slots stay put
+   * @param slot current slot, counting from 1
+   * @param key key to look for
+   * @return size_t next slot
+   */
+  constexpr size_t step(size_t slot, const ItemType &key) const;
+
+  /**
+   * @brief Takes Level search steps, unrolled at compile time
+   *
+   * @pre 1 <= slot
+   * @post returns slot after Level steps
+   * @param slot current slot, counting from 1
+   * @param key key to look for
+   * @return size_t slot reached
+   */
+  template <int Level>
+  constexpr size_t descend(size_t slot, const ItemType &key) const;
+
+  /**
+   * @brief Get slot of the first key not less than key
+   *
+   * @pre none
+   * @post returns slot counting from 1, 0 if every key is less
+   * @param key key to look for
+   * @return size_t lower bound slot
+   */
+  constexpr size_t lowerSlot(const ItemType &key) const;
+
+public:
+  /**
+   * In order iterator that follows the precomputed threads.
+   */
+  class iterator {
+  private:
+    const StaticThreadedSet<ItemType, N> *set; // Set iterated over
+    int index;                                 // Node index, -1 at end
+
+  public:
+    typedef std::bidirectional_iterator_tag iterator_category;
+    typedef ItemType value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const ItemType *pointer;
+    typedef const ItemType &reference;
+
+    /**
+     * @brief Constructor
+     *
+     * @pre index is a node of owner or -1
+     * @post iterator at index
+     * @param owner set to iterate
+     * @param position node index, -1 for end
+     */
+    constexpr iterator(const StaticThreadedSet<ItemType, N> *owner,
+                       int position);
+
+    /**
+     * @brief Get item at this position
+     *
+     * @pre not the end iterator
+     * @post return node item
+     * @return const ItemType& node item
+     */
+    constexpr const ItemType &operator*() const;
+
+    /**
+     * @brief Move to inorder successor
+     *
+     * @pre not the end iterator
+     * @post iterator at successor or end
+     * @return iterator& this iterator
+     */
+    constexpr iterator &operator++();
+
+    /**
+     * @brief Move to inorder predecessor
+     *
+     * @pre not the end iterator
+     * @post iterator at predecessor, end if at the smallest node
+     * @return iterator& this iterator
+     */
+    constexpr iterator &operator--();
+
+    /**
+     * @brief Compare positions
+     *
+     * @pre none
+     * @post return if both are at the same node
+     * @param other iterator to compare with
+     * @return bool true if equal
+     */
+    constexpr bool operator==(const iterator &other) const;
+
+    /**
+     * @brief Compare positions
+     *
+     * @pre none
+     * @post return if iterators are at different nodes
+     * @param other iterator to compare with
+     * @return bool true if not equal
+     */
+    constexpr bool operator!=(const iterator &other) const;
+  }; // end iterator
+
+  /**
+   * @brief Key table constructor
+   *
+   * @pre none, keys may be in any order and may repeat
+   * @post balanced threaded tree holding each distinct key once
+   * @param keys keys of the set
+   */
+  constexpr explicit StaticThreadedSet(const ItemType (&keys)[N]);
+
+  /**
+   * @brief Get number of keys
+   *
+   * @pre none
+   * @post return number of distinct keys, at most N
+   * @return size_t number of keys
+   */
+  constexpr size_t size() const;
+
+  /**
+   * @brief Checks if key is in the set
+   *
+   * @pre none
+   * @post returns if key is in set
+   * @param key key to look for
+   * @return bool true if found
+   */
+  constexpr bool contains(const ItemType &key) const;
+
+  /**
+   * @brief Get the first key not less than given key
+   *
+   * @pre none
+   * @post returns iterator to lower bound or end()
+   * @param key key to look for
+   * @return iterator lower bound position
+   */
+  constexpr iterator lowerBound(const ItemType &key) const;
+
+  /**
+   * @brief Get iterator to the smallest key
+   *
+   * @pre none
+   * @post returns iterator to leftmost node
+   * @return iterator first position
+   */
+  constexpr iterator begin() const;
+
+  /**
+   * @brief Get iterator past the largest key
+   *
+   * @pre none
+   * @post returns end iterator
+   * @return iterator end position
+   */
+  constexpr iterator end() const;
+}; // end StaticThreadedSet
+
+#include "StaticThreadedSet.cpp"
+#endif
@@ -26,12 +26,24 @@ template <typename ItemType> ThreadedBST<ItemType>::ThreadedBST(const int &n) {
   rootPtr = nullptr;
   if (n > 0) {
     insert(1, n);
-    setThread(rootPtr);
   }
 }
 
 /**
- * @brief Recursively halves and adds midpoint from m to n
+ * @brief Duplicate mode constructor
+ *
+ * @pre none
+ * @post empty ThreadedBST that stores duplicates as given
+ * @param mode DUPLICATE_COUNTS to count copies in one node
+ */
+template <typename ItemType>
+ThreadedBST<ItemType>::ThreadedBST(DuplicateMode mode) {
+  rootPtr = nullptr;
+  multiset = mode == DUPLICATE_COUNTS;
+}
+
+/**
+ * @brief Adds m to n in midpoint order so the result stays balanced
  *
  * @pre Existing ThreadedBST
  * @post ThreadedBST with nodes from m to n
@@ -40,15 +52,20 @@ template <typename ItemType> ThreadedBST<ItemType>::ThreadedBST(const int &n) {
  */
 template <typename ItemType>
 void ThreadedBST<ItemType>::insert(const int &m, const int &n) {
-  int mid = (n + m) / 2;
-  if (mid != m && mid != n) {
-    add(rootPtr, mid);
-    insert(m, mid - 1);
-    insert(mid + 1, n);
-  } else {
-    add(rootPtr, n);
-    if (m != n) {
-      add(rootPtr, m);
+  if (m > n) {
+    return;
+  }
+  // Number i of the sequence (counting from 1) is added once every number
+  // with more trailing zero bits has been added, which is the order the
+  // recursive midpoint split visits them in, without needing a stack
+  const long size = (long)n - m + 1;
+  long step = 1;
+  while (step * 2 <= size) {
+    step *= 2;
+  }
+  for (; step > 0; step /= 2) {
+    for (long i = step; i <= size; i += 2 * step) {
+      add(rootPtr, (ItemType)(m + i - 1));
     }
   }
 }
@@ -63,11 +80,50 @@ void ThreadedBST<ItemType>::insert(const int &m, const int &n) {
 template <typename ItemType>
 ThreadedBST<ItemType>::ThreadedBST(const ThreadedBST<ItemType> &tree) {
   rootPtr = nullptr;
-  if (tree.count > 0) {
-    insert(1, tree.count);
-    setThread(rootPtr);
+  multiset = tree.multiset;
+  access = tree.access;
+  splayMinDepth = tree.splayMinDepth;
+  lazy = tree.lazy;
+  maxDeadFraction = tree.maxDeadFraction;
+  filtered = tree.filtered;
+  filterBitsPerKey = tree.filterBitsPerKey;
+  filterPrefixBits = tree.filterPrefixBits;
+  keyFilter = tree.keyFilter;
+  rangeFilter = tree.rangeFilter;
+  filterCapacity = tree.filterCapacity;
+  filterKeys = tree.filterKeys;
+  filterRemoved = tree.filterRemoved;
+  BinaryNode<ItemType> *src = tree.rootPtr;
+  if (src == nullptr) {
+    return;
+  }
+  rootPtr = new BinaryNode<ItemType>(src->getItem());
+  rootPtr->setCount(src->getCount());
+  count = tree.count;
+  dead = tree.dead;
+  height = tree.height;
+  BinaryNode<ItemType> *dst = rootPtr;
+
+  // Preorder walk of both trees in step, using the threads to climb back up
+  while (true) {
+    if (!(src->getLeftThread()) && src->getLeftChildPtr() != nullptr) {
+      src = src->getLeftChildPtr();
+      dst = attachLeft(dst, src->getItem());
+      dst->setCount(src->getCount());
+      continue;
+    }
+    // Follow successor threads up to the next node with a right subtree
+    while (src->getRightThread()) {
+      src = src->getRightChildPtr();
+      dst = dst->getRightChildPtr();
+    }
+    if (src->getRightChildPtr() == nullptr) {
+      break;
+    }
+    src = src->getRightChildPtr();
+    dst = attachRight(dst, src->getItem());
+    dst->setCount(src->getCount());
   }
-  removeEven();
 }
 
 /**
@@ -78,430 +134,2538 @@ ThreadedBST<ItemType>::ThreadedBST(const ThreadedBST<ItemType> &tree) {
  */
 template <typename ItemType> ThreadedBST<ItemType>::~ThreadedBST() {
   clear(rootPtr);
+  abandonCompaction();
+  clear(compaction.retired);
 }
 
 /**
  * @brief Get depth
  *
  * @pre none
- * @post return tree depth
+ * @post return tree depth, tracked on every change so it is exact while
+ *       only adding and an upper bound after removals or splaying until
+ *       stats()
  * @return int depth
  */
 template <typename ItemType> int ThreadedBST<ItemType>::getDepth() const {
-  return log2(count + 1);
+  return height;
 }
 
 /**
- * @brief Adds new node to tree
+ * @brief Measure the shape of the tree
  *
  * @pre none
- * @post new node is added to tree and returned
- * @param node tree pointer
- * @param data data of new node
- * @return BinaryNode<ItemType>* pointer to new node
+ * @post returns structural statistics, getDepth() is exact afterwards
+ * @return TreeShape height, path lengths, depth histogram, link counts,
+ *         memory estimate and locality of the tree
  */
-template <typename ItemType>
-BinaryNode<ItemType> *ThreadedBST<ItemType>::add(BinaryNode<ItemType> *node,
-                                                 const ItemType &newEntry) {
-  // 1. If the tree is empty, return a new, single node
-  if (node == nullptr) {
-    count++;
-    if (rootPtr == nullptr) {
-      rootPtr = new BinaryNode<ItemType>(newEntry);
-      return rootPtr;
+template <typename ItemType> TreeShape ThreadedBST<ItemType>::stats() const {
+  TreeShape shape;
+  shape.memoryBytes = sizeof(ThreadedBST<ItemType>);
+  if (rootPtr == nullptr) {
+    height = 0;
+    return shape;
+  }
+
+  long long pathTotal = 0;
+  double distanceTotal = 0;
+  BinaryNode<ItemType> *prev = nullptr;
+
+  // Inorder walk that knows the level of every node without a stack.
+  // Going down a child adds a level. Coming back up a thread to node, the
+  // level is recovered by counting the right steps from node's left child
+  // to where the thread started, each edge is counted at most twice.
+  BinaryNode<ItemType> *node = rootPtr;
+  int level = 1;
+  while (node->getLeftChildPtr() != nullptr && !(node->getLeftThread())) {
+    node = node->getLeftChildPtr();
+    level++;
+  }
+  while (node != nullptr) {
+    // Visit node
+    shape.nodes++;
+    if (node->getCount() == 0) {
+      shape.tombstones++;
+    }
+    if (node->getInBlock()) {
+      shape.blockNodes++;
+    }
+    pathTotal += level;
+    if ((int)shape.depthHistogram.size() < level) {
+      shape.depthHistogram.resize(level, 0);
+    }
+    shape.depthHistogram[level - 1]++;
+    if (node->getLeftThread()) {
+      shape.threadLinks++;
+    } else if (node->getLeftChildPtr() != nullptr) {
+      shape.childLinks++;
+    } else {
+      shape.nullLinks++;
+    }
+    if (node->getRightThread()) {
+      shape.threadLinks++;
+    } else if (node->getRightChildPtr() != nullptr) {
+      shape.childLinks++;
+    } else {
+      shape.nullLinks++;
+    }
+    if (prev != nullptr) {
+      long long distance = (long long)((char *)node - (char *)prev);
+      distanceTotal += distance < 0 ? -distance : distance;
+    }
+    prev = node;
+
+    // Move to inorder successor
+    if (node->getRightThread()) {
+      BinaryNode<ItemType> *from = node;
+      node = node->getRightChildPtr();
+      level--;
+      for (BinaryNode<ItemType> *step = node->getLeftChildPtr(); step != from;
+           step = step->getRightChildPtr()) {
+        level--;
+      }
+    } else {
+      node = node->getRightChildPtr();
+      if (node != nullptr) {
+        level++;
+        while (node->getLeftChildPtr() != nullptr &&
+               !(node->getLeftThread())) {
+          node = node->getLeftChildPtr();
+          level++;
+        }
+      }
     }
-    return new BinaryNode<ItemType>(newEntry);
   }
-  BinaryNode<ItemType> *temp = nullptr;
 
-  // 2. Otherwise, recur down the tree
-  if (newEntry < node->getItem()) {
-    temp = add(node->getLeftChildPtr(), newEntry);
-    node->setLeftChildPtr(temp);
-  } else {
-    temp = add(node->getRightChildPtr(), newEntry);
-    node->setRightChildPtr(temp);
+  shape.height = (int)shape.depthHistogram.size();
+  shape.maxPathLength = shape.height;
+  shape.averagePathLength = (double)pathTotal / shape.nodes;
+  if (shape.nodes > 1) {
+    shape.localityScore = distanceTotal / (shape.nodes - 1);
   }
-  // return the (unchanged) node pointer
-  return node;
+  // Heap chunks are rounded to 16 bytes and carry an 8 byte header, a
+  // node in a block takes just its slot
+  const size_t chunk = (sizeof(BinaryNode<ItemType>) + 8 + 15) / 16 * 16;
+  shape.memoryBytes += (size_t)(shape.nodes - shape.blockNodes) * chunk +
+                       (size_t)shape.blockNodes * sizeof(BinaryNode<ItemType>);
+  height = shape.height;
+  return shape;
 }
 
 /**
- * @brief Removes node with given data if exists
+ * @brief Get duplicate mode
  *
  * @pre none
- * @post removes node if exists and returns inorder successor
- * @param node tree pointer
- * @param data data of node to remove
- * @return BinaryNode<ItemType>* inorder successor of removed node
+ * @post return how duplicates are stored
+ * @return DuplicateMode duplicate mode
  */
 template <typename ItemType>
-BinaryNode<ItemType> *
-ThreadedBST<ItemType>::removeNode(BinaryNode<ItemType> *node, int data) {
-  BinaryNode<int> *parent = nullptr; // parent of removed node
-  BinaryNode<int> *ptr = node;       // pointer for removed node
-
-  // Set true if key is found
-  bool found = false;
-
-  // Search data in tree and find node to be removed and its parent
-  while (ptr != nullptr) {
-    if (data == ptr->getItem()) {
-      found = true;
-      break;
-    }
-    parent = ptr;
-    if (data < ptr->getItem()) {
-      if (!(ptr->getLeftThread()))
-        ptr = ptr->getLeftChildPtr();
-      else
-        break;
-    } else {
-      if (!(ptr->getRightThread()))
-        ptr = ptr->getRightChildPtr();
-      else
-        break;
-    }
-  }
+typename ThreadedBST<ItemType>::DuplicateMode
+ThreadedBST<ItemType>::getDuplicateMode() const {
+  return multiset ? DUPLICATE_COUNTS : DUPLICATE_NODES;
+}
 
-  if (!found) {
-    cout << "Data not present in tree" << endl;
-    return nullptr;
-  }
-  // Two Children
-  else if (!(ptr->getLeftThread()) && !(ptr->getRightThread()) &&
-           ptr->getLeftChildPtr() != nullptr &&
-           ptr->getRightChildPtr() != nullptr) {
-    node = caseC(node, ptr);
-  }
+/**
+ * @brief Set how lookups change the shape of the tree
+ *
+ * @pre minDepth >= 1
+ * @post later lookups on a non-const tree follow mode
+ * @param mode access mode
+ * @param minDepth nodes found above this depth are left in place
+ */
+template <typename ItemType>
+void ThreadedBST<ItemType>::setAccessMode(AccessMode mode, int minDepth) {
+  access = mode;
+  splayMinDepth = max(minDepth, 1);
+}
 
-  // Only Left Child
-  else if (!(ptr->getLeftThread()) && ptr->getLeftChildPtr() != nullptr) {
-    node = caseB(parent, ptr);
-  }
+/**
+ * @brief Get access mode
+ *
+ * @pre none
+ * @post return how lookups change the shape of the tree
+ * @return AccessMode access mode
+ */
+template <typename ItemType>
+typename ThreadedBST<ItemType>::AccessMode
+ThreadedBST<ItemType>::getAccessMode() const {
+  return (AccessMode)access;
+}
 
-  // Only Right Child
-  else if (!(ptr->getRightThread()) && ptr->getRightChildPtr() != nullptr) {
-    node = caseB(parent, ptr);
-  }
-  // No Children
-  else {
-    node = caseA(node, parent, ptr);
-  }
+/**
+ * @brief Turn lazy deletion on or off
+ *
+ * @pre 0 <= maxDead < 1
+ * @post removals leave tombstones while enabled, compacting once they
+ *       pass maxDead of the nodes. Turning it off drops tombstones now.
+ * @param enabled true to leave tombstones
+ * @param maxDead fraction of nodes that may be tombstones
+ */
+template <typename ItemType>
+void ThreadedBST<ItemType>::setLazyDelete(bool enabled, double maxDead) {
+  lazy = enabled;
+  maxDeadFraction = enabled ? maxDead : 0;
+  checkTombstones();
+}
 
-  count--;
-  return node;
+/**
+ * @brief Get if lazy deletion is on
+ *
+ * @pre none
+ * @post return if removals leave tombstones
+ * @return bool true if lazy
+ */
+template <typename ItemType> bool ThreadedBST<ItemType>::getLazyDelete() const {
+  return lazy;
 }
 
 /**
- * @brief Remove a node with no children
+ * @brief Turn the lookup filters on or off
  *
- * @pre a node with no children
- * @post removes node and returns inorder successor
- * @param node tree pointer
- * @param parent parent of removed node
- * @param ptr pointer for removed node
- * @return BinaryNode<int>* inorder successor of removed node
+ * @pre bitsPerKey > 0, 0 <= prefixBits < 64
+ * @post lookups of missing keys mostly skip the tree while enabled.
+ *       With prefixBits > 0 and integer keys, keys that agree above
+ *       their prefixBits low bits share a range filter entry.
+ * @param enabled true to filter lookups
+ * @param bitsPerKey filter bits per key, 10 gives about 1% false
+ *        positives
+ * @param prefixBits low key bits a range filter entry drops, 0 for no
+ *        range filter
  */
 template <typename ItemType>
-BinaryNode<int> *ThreadedBST<ItemType>::caseA(BinaryNode<int> *node,
-                                              BinaryNode<int> *parent,
-                                              BinaryNode<int> *ptr) {
-  // If node to be removed is rootPtr
-  if (parent == nullptr) {
-    rootPtr = nullptr;
-    delete node;
-    node = nullptr;
-  }
-  // If node to be removed is left of its parent
-  else if (ptr == parent->getLeftChildPtr()) {
-    if (ptr->getLeftChildPtr() != nullptr) {
-      parent->setLeftThread(true);
-    }
-    parent->setLeftChildPtr(ptr->getLeftChildPtr());
-  } else {
-    if (ptr->getRightChildPtr() != nullptr) {
-      parent->setRightThread(true);
-    }
-    parent->setRightChildPtr(ptr->getRightChildPtr());
+void ThreadedBST<ItemType>::setFilter(bool enabled, int bitsPerKey,
+                                      int prefixBits) {
+  filtered = enabled;
+  filterBitsPerKey = bitsPerKey;
+  filterPrefixBits = is_integral<ItemType>::value ? prefixBits : 0;
+  // Turning them off frees the filters, turning them on builds them
+  filterCapacity = 0;
+  filterKeys = 0;
+  filterRemoved = 0;
+  if (!enabled) {
+    keyFilter = BloomFilter<ItemType>();
+    rangeFilter = BloomFilter<uint64_t>();
   }
+  rebuildFilter();
+}
 
-  // Free memory and return inorder successor of removed node
-  if (node != nullptr) {
-    delete ptr;
-  }
-  ptr = nullptr;
-  return parent;
+/**
+ * @brief Get if the lookup filters are on
+ *
+ * @pre none
+ * @post return if lookups are filtered
+ * @return bool true if filtered
+ */
+template <typename ItemType> bool ThreadedBST<ItemType>::getFilter() const {
+  return filtered;
 }
 
 /**
- * @brief Remove a node with one child
+ * @brief Adds new node to tree
  *
- * @pre a node with one child
- * @post removes node and returns inorder successor
- * @param parent parent of removed node
- * @param ptr pointer for removed node
- * @return BinaryNode<int>* inorder successor of removed node
+ * @pre none
+ * @post new node is added to tree with threads set and returned, when
+ *       counting duplicates an existing node for data is counted up
+ *       instead
+ * @param node tree pointer, nullptr for the root
+ * @param data data of new node
+ * @return BinaryNode<ItemType>* pointer to node holding data
  */
 template <typename ItemType>
-BinaryNode<int> *ThreadedBST<ItemType>::caseB(BinaryNode<int> *parent,
-                                              BinaryNode<int> *ptr) {
-  BinaryNode<int> *child;
-  // Checks if the child node to be deleted has a left child.
-  // Also indicates whether node is leftmost of rootptr
-  if (ptr->getLeftThread() == false && ptr->getLeftChildPtr() != nullptr) {
-    child = ptr->getLeftChildPtr();
-  }
-  // The child node to be removed has a right child.
-  else {
-    child = ptr->getRightChildPtr();
-  }
-  // if node to be removed is the tree root.
-  if (parent == nullptr) {
-    rootPtr = child;
-    // the node is the left child of its parent.
-  } else if (ptr == parent->getLeftChildPtr()) {
-    parent->setLeftChildPtr(child);
+BinaryNode<ItemType> *ThreadedBST<ItemType>::add(BinaryNode<ItemType> *node,
+                                                 const ItemType &newEntry) {
+  TBST_TIMER(ADD);
+  if (node == nullptr) {
+    node = rootPtr;
   }
-  // the node is the right child of its parent.
-  else {
-    parent->setRightChildPtr(child);
+  filterAdd(newEntry);
+  // 1. If the tree is empty, return a new, single node
+  if (node == nullptr) {
+    count++;
+    rootPtr = new BinaryNode<ItemType>(newEntry);
+    height = max(height, 1);
+    noteChange(rootPtr, 1);
+    return rootPtr;
   }
-  // Find the successor and predecessor of the node
-  BinaryNode<int> *s = inorderSucc(ptr);
-  BinaryNode<int> *p = inorderPred(ptr);
 
-  // If the ptr has left subtree.
-  if (ptr->getLeftThread() == false && p != nullptr) {
-    p->setRightChildPtr(s);
-  }
-  // If the ptr has right subtree.
-  else {
-    if (ptr->getRightThread() == false && s != nullptr)
-      s->setLeftChildPtr(p);
-  }
-  // Updates left thread boolean variables
-  if (rootPtr->getLeftThread()) {
-    rootPtr->setLeftThread(false);
-    // Updates right thread boolean variables
-  } else if (rootPtr->getRightThread()) {
-    rootPtr->setRightThread(false);
+  // 2. Otherwise, walk down the tree until a thread or end is reached,
+  // counting levels so the height stays current
+  int level = 2;
+  while (true) {
+    TBST_STAT(NODES_VISITED);
+    TBST_STAT(COMPARISONS);
+    if (newEntry < node->getItem()) {
+      if (node->getLeftThread() || node->getLeftChildPtr() == nullptr) {
+        count++;
+        height = max(height, level);
+        node = attachLeft(node, newEntry);
+        noteChange(node, 1);
+        return node;
+      }
+      TBST_STAT(CHILD_FOLLOWS);
+      node = node->getLeftChildPtr();
+    } else if (multiset && !(node->getItem() < newEntry)) {
+      // Equal key, count another copy without a new node
+      TBST_STAT(COMPARISONS);
+      if (node->getCount() == 0) {
+        dead--;
+      }
+      node->setCount(node->getCount() + 1);
+      noteChange(node, 1);
+      return node;
+    } else {
+      if (node->getRightThread() || node->getRightChildPtr() == nullptr) {
+        count++;
+        height = max(height, level);
+        node = attachRight(node, newEntry);
+        noteChange(node, 1);
+        return node;
+      }
+      TBST_STAT(CHILD_FOLLOWS);
+      node = node->getRightChildPtr();
+    }
+    level++;
   }
-  // Free memory
-  delete ptr;
-  ptr = nullptr;
-  // return succesor
-  return s;
 }
 
 /**
- * @brief Remove a node with two children
+ * @brief Checks if a node with given data exists
  *
- * @pre a node with two children
- * @post removes node and returns inorder successor
- * @param node tree pointer
- * @param ptr pointer for removed node
- * @return BinaryNode<int>* inorder successor of removed node
+ * @pre none
+ * @post returns if data is in tree
+ * @param data data to look for
+ * @return bool true if found
  */
 template <typename ItemType>
-BinaryNode<int> *ThreadedBST<ItemType>::caseC(BinaryNode<int> *node,
-                                              BinaryNode<int> *ptr) {
-  // Find inorder successor and its parent.
-  BinaryNode<int> *parsucc = ptr;
-  BinaryNode<int> *succ = ptr->getRightChildPtr();
-
-  // Find leftmost child of successor
-  while (succ->getLeftChildPtr() != nullptr && !(succ->getLeftThread())) {
-    parsucc = succ;
-    succ = succ->getLeftChildPtr();
+bool ThreadedBST<ItemType>::contains(const ItemType &data) const {
+  TBST_TIMER(FIND);
+  if (filteredOut(data)) {
+    return false;
   }
-
-  ptr->setItem(succ->getItem());
-
-  if (succ->getLeftThread() && succ->getRightThread()) {
-    node = caseA(node, parsucc, succ);
-  } else {
-    node = caseB(parsucc, succ);
+  BinaryNode<ItemType> *node = rootPtr;
+  while (node != nullptr) {
+    TBST_STAT(NODES_VISITED);
+    if (data < node->getItem()) {
+      TBST_STAT(COMPARISONS);
+      node = node->getLeftThread() ? nullptr : node->getLeftChildPtr();
+    } else if (node->getItem() < data) {
+      TBST_STAT_ADD(COMPARISONS, 2);
+      node = node->getRightThread() ? nullptr : node->getRightChildPtr();
+    } else {
+      TBST_STAT_ADD(COMPARISONS, 2);
+      // A tombstone may still have live duplicates
+      return node->getCount() > 0 || liveNode(data) != nullptr;
+    }
   }
-  return node;
+  return false;
 }
 
 /**
- * @brief Returns inorder successor of node
+ * @brief Checks if a node with given data exists, splaying it
  *
  * @pre none
- * @post returns inorder successor of node
- * @param ptr node to get inorder successor of
- * @return BinaryNode<int>* inorder successor of node
+ * @post returns if data is in tree, the node reached is splayed as the
+ *       access mode says
+ * @param data data to look for
+ * @return bool true if found
  */
 template <typename ItemType>
-BinaryNode<int> *ThreadedBST<ItemType>::inorderSucc(BinaryNode<int> *ptr) {
-  // If successor thread is found returns successor
-  if (ptr->getRightThread()) {
-    return ptr->getRightChildPtr();
+bool ThreadedBST<ItemType>::contains(const ItemType &data) {
+  if (access == ACCESS_STATIC) {
+    return as_const(*this).contains(data);
   }
-
-  // If successor contains a smaller left child node
-  // Returns left most child node of successor
-  ptr = getLeftMost(ptr->getRightChildPtr());
-  return ptr;
+  TBST_TIMER(FIND);
+  if (filteredOut(data)) {
+    return false;
+  }
+  return accessNode(data) != nullptr;
 }
 
 /**
- * @brief Returns inorder predecessor of node
+ * @brief Get number of copies of given data
  *
  * @pre none
- * @post returns inorder predecessor of node
- * @param ptr node to get inorder predecessor of
- * @return BinaryNode<int>* inorder predecessor of node
+ * @post returns copies of data in tree
+ * @param data data to look for
+ * @return int number of copies
  */
 template <typename ItemType>
-BinaryNode<int> *ThreadedBST<ItemType>::inorderPred(BinaryNode<int> *ptr) {
-  // If predessor thread is found returns predecessor
-  if (ptr->getLeftThread()) {
-    return ptr->getLeftChildPtr();
+int ThreadedBST<ItemType>::countOf(const ItemType &data) const {
+  TBST_TIMER(FIND);
+  if (filteredOut(data)) {
+    return 0;
   }
-
-  // If parameter node is leftmost the predessor is nullptr
-  // Returns nullptr
-  if (ptr == getLeftMost(rootPtr)) {
-    return nullptr;
+  // Separate duplicate nodes are adjacent in inorder
+  int copies = 0;
+  for (BinaryNode<ItemType> *node = lowerBound(data);
+       node != nullptr && !(data < node->getItem());
+       node = inorderSucc(node)) {
+    copies += node->getCount();
   }
-
-  // If predecessor contains a larger right child node
-  // Returns right most child node of predecessor
-  ptr = getRightMost(ptr->getLeftChildPtr());
-  return ptr;
+  return copies;
 }
 
 /**
- * @brief Empty tree and deallocate memory
+ * @brief Get the first node not less than given data
  *
  * @pre none
- * @post tree is emptied and memory is deallocated
- * @param node tree pointer
+ * @post returns lower bound node or nullptr
+ * @param data data to look for
+ * @return BinaryNode<ItemType>* first node not less than data
  */
 template <typename ItemType>
-void ThreadedBST<ItemType>::clear(BinaryNode<ItemType> *node) {
-  // Node is not empty
-  if (node != nullptr) {
-    // Node has left child
-    if (!(node->getLeftThread())) {
-      // Calls clear on left child
-      clear(node->getLeftChildPtr());
-    }
-    // Node has right child
-    if (!(node->getRightThread())) {
-      // Calls clear on right child
-      clear(node->getRightChildPtr());
+BinaryNode<ItemType> *
+ThreadedBST<ItemType>::lowerBound(const ItemType &data) const {
+  TBST_TIMER(FIND);
+  BinaryNode<ItemType> *node = rootPtr;
+  BinaryNode<ItemType> *bound = nullptr;
+  while (node != nullptr) {
+    TBST_STAT(NODES_VISITED);
+    TBST_STAT(COMPARISONS);
+    if (node->getItem() < data) {
+      node = node->getRightThread() ? nullptr : node->getRightChildPtr();
+    } else {
+      // Candidate, a smaller one may still be in the left subtree
+      bound = node;
+      node = node->getLeftThread() ? nullptr : node->getLeftChildPtr();
     }
-    // Deletes left child pointer
-    node->setLeftChildPtr(nullptr);
-    // Deletes right child pointer
-    node->setRightChildPtr(nullptr);
+  }
+  while (bound != nullptr && bound->getCount() == 0) {
+    bound = inorderSucc(bound);
+  }
+  return bound;
+}
 
-    // Node has no used pointers or children
-    if (node->getLeftChildPtr() == nullptr &&
-        node->getRightChildPtr() == nullptr) {
-      // Deletes node
-      delete node;
-      node = nullptr;
-    }
+/**
+ * @brief Get distance between keys
+ *
+ * @pre ItemType supports subtraction
+ * @post return absolute difference, without overflow for integer keys
+ * @param a first key
+ * @param b second key
+ * @return result_type distance
+ */
+template <typename ItemType>
+typename ThreadedBST<ItemType>::KeyDistance::result_type
+ThreadedBST<ItemType>::KeyDistance::operator()(const ItemType &a,
+                                               const ItemType &b) const {
+  const ItemType &low = a < b ? a : b;
+  const ItemType &high = a < b ? b : a;
+  if constexpr (is_same<result_type, ItemType>::value) {
+    // Subtract the smaller key so unsigned keys do not wrap
+    return high - low;
+  } else {
+    // high - low fits the unsigned type, where wrapping subtraction
+    // gets it even when the signed one would overflow
+    return (result_type)((result_type)high - (result_type)low);
   }
 }
 
-// gets the leftmost node in the threaded BST
-// Returns the leftmost node in the tree
 /**
- * @brief Get the leftmost node of given tree
+ * @brief Get the live node before a position
  *
- * @pre none
- * @post returns leftmost node
- * @param node tree pointer
- * @return BinaryNode<ItemType>* leftmode node
+ * @pre node is in tree or nullptr
+ * @post returns largest live node less than node, the largest live
+ *       node if node is nullptr, nullptr if none
+ * @param node position, nullptr for past the largest node
+ * @return BinaryNode<ItemType>* live predecessor
  */
 template <typename ItemType>
 BinaryNode<ItemType> *
-ThreadedBST<ItemType>::getLeftMost(BinaryNode<ItemType> *node) const {
-  // Node is empty
-  if (node == nullptr) {
-    // Returns empty node
-    return nullptr;
-  }
-  // While there is a possible left child to access
-  // Checks if left child node is a thread or already left most of tree
-  while (node->getLeftChildPtr() != nullptr && !(node->getLeftThread())) {
-    // Iterates to left child ptr
-    node = node->getLeftChildPtr();
+ThreadedBST<ItemType>::livePred(BinaryNode<ItemType> *node) const {
+  node = (node == nullptr) ? getRightMost(rootPtr) : inorderPred(node);
+  while (node != nullptr && node->getCount() == 0) {
+    node = inorderPred(node);
   }
-  // Returns left most node
   return node;
 }
 
 /**
- * @brief Get the rightmost node of given tree
+ * @brief Get the live node after a node
  *
- * @pre none
- * @post returns rightmost node
- * @param node tree pointer
- * @return BinaryNode<ItemType>* rightmode node
+ * @pre node is in tree
+ * @post returns smallest live node greater than node or nullptr
+ * @param node position
+ * @return BinaryNode<ItemType>* live successor
  */
 template <typename ItemType>
 BinaryNode<ItemType> *
-ThreadedBST<ItemType>::getRightMost(BinaryNode<ItemType> *node) const {
-  if (node == nullptr) {
-    return nullptr;
-  }
-  while (node->getRightChildPtr() != nullptr && !(node->getRightThread())) {
-    node = node->getRightChildPtr();
-  }
+ThreadedBST<ItemType>::liveSucc(BinaryNode<ItemType> *node) const {
+  do {
+    node = inorderSucc(node);
+  } while (node != nullptr && node->getCount() == 0);
   return node;
 }
 
 /**
- * @brief Set tree threads
+ * @brief Get the largest node not greater than given data
  *
  * @pre none
- * @post tree turns into ThreadedBST
- * @param node tree pointer
+ * @post returns floor node or nullptr
+ * @param data data to look for
+ * @return BinaryNode<ItemType>* last node not greater than data
  */
 template <typename ItemType>
-void ThreadedBST<ItemType>::setThread(BinaryNode<ItemType> *node) {
-  if (node != nullptr) {
-    if (!(node->getLeftThread()) && node != getLeftMost(rootPtr)) {
-      BinaryNode<ItemType> *tempLeft = getRightMost(node->getLeftChildPtr());
-      tempLeft->setRightChildPtr(node);
-      tempLeft->setRightThread(true);
-      setThread(node->getLeftChildPtr());
-    }
-    if (!(node->getRightThread()) && node != getRightMost(rootPtr)) {
-      BinaryNode<ItemType> *tempRight = getLeftMost(node->getRightChildPtr());
-      tempRight->setLeftChildPtr(node);
-      tempRight->setLeftThread(true);
-      setThread(node->getRightChildPtr());
-    }
+BinaryNode<ItemType> *ThreadedBST<ItemType>::floor(const ItemType &data) const {
+  TBST_TIMER(FIND);
+  BinaryNode<ItemType> *node = lowerBound(data);
+  if (node != nullptr && !(data < node->getItem())) {
+    return node;
   }
+  // Everything from the lower bound on is greater, so step back one
+  return livePred(node);
 }
 
 /**
- * @brief Remove even nodes
+ * @brief Get the smallest node not less than given data
  *
  * @pre none
- * @post tree with odd nodes
+ * @post returns ceiling node or nullptr
+ * @param data data to look for
+ * @return BinaryNode<ItemType>* first node not less than data
  */
-template <typename ItemType> void ThreadedBST<ItemType>::removeEven() {
-  BinaryNode<ItemType> *node =
-      getLeftMost(rootPtr); // traverses through tree (inorder)
+template <typename ItemType>
+BinaryNode<ItemType> *
+ThreadedBST<ItemType>::ceiling(const ItemType &data) const {
+  return lowerBound(data);
+}
+
+/**
+ * @brief Get the node closest to given data
+ *
+ * @pre distance(a, b) is symmetric and grows away from a in both
+ *      directions
+ * @post returns closest node, the smaller one on a tie, nullptr if tree
+ *       is empty
+ * @param data data to look for
+ * @param distance functor giving the distance between two keys
+ * @return BinaryNode<ItemType>* nearest node
+ */
+template <typename ItemType>
+template <class Distance>
+BinaryNode<ItemType> *ThreadedBST<ItemType>::nearest(const ItemType &data,
+                                                     Distance distance) const {
+  TBST_TIMER(FIND);
+  BinaryNode<ItemType> *upper = lowerBound(data);
+  if (upper != nullptr && !(data < upper->getItem())) {
+    return upper;
+  }
+  BinaryNode<ItemType> *lower = livePred(upper);
+  if (lower == nullptr || upper == nullptr) {
+    return lower == nullptr ? upper : lower;
+  }
+  return distance(data, lower->getItem()) <= distance(data, upper->getItem())
+             ? lower
+             : upper;
+}
+
+/**
+ * @brief Get the keys closest to given data
+ *
+ * @pre out has room for k keys, distance is as for nearest
+ * @post up to k keys are written nearest first, the smaller key first on
+ *       a tie, a counted key once per copy
+ * @param data data to look for
+ * @param k number of keys wanted
+ * @param out buffer to write to
+ * @param distance functor giving the distance between two keys
+ * @return size_t number of keys written, less than k only if the tree
+ *         holds fewer
+ */
+template <typename ItemType>
+template <class Distance>
+size_t ThreadedBST<ItemType>::kNearest(const ItemType &data, size_t k,
+                                       ItemType *out, Distance distance) const {
+  TBST_TIMER(FIND);
+  // Two pointers start on either side of where data would go and move
+  // apart, like merging the keys below and above by their distance
+  BinaryNode<ItemType> *upper = lowerBound(data);
+  BinaryNode<ItemType> *lower = livePred(upper);
+  size_t written = 0;
+  while (written < k && (lower != nullptr || upper != nullptr)) {
+    const bool takeLower =
+        upper == nullptr ||
+        (lower != nullptr &&
+         distance(data, lower->getItem()) <= distance(data, upper->getItem()));
+    BinaryNode<ItemType> *node = takeLower ? lower : upper;
+    const size_t copies = min((size_t)node->getCount(), k - written);
+    for (size_t i = 0; i < copies; i++) {
+      out[written++] = node->getItem();
+    }
+    if (takeLower) {
+      lower = livePred(lower);
+    } else {
+      upper = liveSucc(upper);
+    }
+  }
+  return written;
+}
+
+/**
+ * @brief Checks if any key lies in a range
+ *
+ * @pre none
+ * @post returns if some key k has low <= k < high
+ * @param low smallest key of the range
+ * @param high key just past the range
+ * @return bool true if the range holds a key
+ */
+template <typename ItemType>
+bool ThreadedBST<ItemType>::containsRange(const ItemType &low,
+                                          const ItemType &high) const {
+  TBST_TIMER(FIND);
+  if (!(low < high)) {
+    return false;
+  }
+  if constexpr (is_integral<ItemType>::value) {
+    if (filtered && filterPrefixBits > 0) {
+      // The range is empty if none of the prefixes it spans was added
+      const uint64_t first = prefixOf(low);
+      const uint64_t last = prefixOf(high - 1);
+      if (last - first < MAX_RANGE_PROBES) {
+        bool maybe = false;
+        for (uint64_t prefix = first; !maybe && prefix <= last; prefix++) {
+          maybe = rangeFilter.mayContain(prefix);
+        }
+        if (!maybe) {
+          return false;
+        }
+      }
+    }
+  }
+  BinaryNode<ItemType> *node = lowerBound(low);
+  return node != nullptr && node->getItem() < high;
+}
+
+/**
+ * @brief Find a node and its parent
+ *
+ * @pre none
+ * @post returns node with given data or nullptr, parent is set
+ * @param node tree pointer to search from
+ * @param data data to look for
+ * @param parent parent of the returned node
+ * @return BinaryNode<ItemType>* node with given data
+ */
+template <typename ItemType>
+BinaryNode<ItemType> *
+ThreadedBST<ItemType>::findNode(BinaryNode<ItemType> *node,
+                                const ItemType &data,
+                                BinaryNode<ItemType> *&parent) const {
+  parent = nullptr;
+  // Search data in tree, threads end the search
+  while (node != nullptr) {
+    TBST_STAT(NODES_VISITED);
+    TBST_STAT(COMPARISONS);
+    if (data == node->getItem()) {
+      return node;
+    }
+    parent = node;
+    TBST_STAT(COMPARISONS);
+    if (data < node->getItem()) {
+      node = node->getLeftThread() ? nullptr : node->getLeftChildPtr();
+    } else {
+      node = node->getRightThread() ? nullptr : node->getRightChildPtr();
+    }
+  }
+  return nullptr;
+}
+
+/**
+ * @brief Removes a node that has been found
+ *
+ * @pre ptr is in tree and parent is its parent
+ * @post removes node and returns inorder successor
+ * @param parent parent of removed node
+ * @param ptr pointer for removed node
+ * @return BinaryNode<ItemType>* inorder successor of removed node
+ */
+template <typename ItemType>
+BinaryNode<ItemType> *
+ThreadedBST<ItemType>::removeFound(BinaryNode<ItemType> *parent,
+                                   BinaryNode<ItemType> *ptr) {
+  bool hasLeft = !(ptr->getLeftThread()) && ptr->getLeftChildPtr() != nullptr;
+  bool hasRight =
+      !(ptr->getRightThread()) && ptr->getRightChildPtr() != nullptr;
+  BinaryNode<ItemType> *succ;
+  // The copy of a running compaction resumes at the node that holds the
+  // next item once ptr is gone, which caseC moves into ptr
+  bool moveCursor = false;
+  if (compaction.running) {
+    noteChange(ptr, -ptr->getCount());
+    moveCursor = compaction.cursor != nullptr &&
+                 (compaction.cursor == ptr ||
+                  compaction.cursor == inorderSucc(ptr));
+  }
+
+  // Two Children
+  if (hasLeft && hasRight) {
+    succ = caseC(ptr);
+  }
+  // Only Left Child or Only Right Child
+  else if (hasLeft || hasRight) {
+    succ = caseB(parent, ptr);
+  }
+  // No Children
+  else {
+    succ = caseA(parent, ptr);
+  }
+  if (moveCursor) {
+    compaction.cursor = succ;
+  }
+
+  count--;
+  filterRemove(1);
+  // Removing never adds levels, so height stays an upper bound
+  if (count == 0) {
+    height = 0;
+    // No node is left in any block
+    blocks.clear();
+  }
+  return succ;
+}
+
+/**
+ * @brief Get the parent of a node from the threads around it
+ *
+ * @pre node is in tree
+ * @post returns parent of node, nullptr for the root
+ * @param node node to find the parent of
+ * @return BinaryNode<ItemType>* parent of node
+ */
+template <typename ItemType>
+BinaryNode<ItemType> *
+ThreadedBST<ItemType>::parentOf(BinaryNode<ItemType> *node) const {
+  // The subtree of a left child ends just before its parent, so the
+  // successor thread of its rightmost node leads there. The subtree of a
+  // right child starts just after its parent, where the predecessor
+  // thread of its leftmost node leads.
+  BinaryNode<ItemType> *after = getRightMost(node)->getRightChildPtr();
+  if (after != nullptr && !(after->getLeftThread()) &&
+      after->getLeftChildPtr() == node) {
+    return after;
+  }
+  BinaryNode<ItemType> *before = getLeftMost(node)->getLeftChildPtr();
+  if (before != nullptr && !(before->getRightThread()) &&
+      before->getRightChildPtr() == node) {
+    return before;
+  }
+  return nullptr;
+}
+
+/**
+ * @brief Removes node with given data if exists
+ *
+ * @pre none
+ * @post removes one copy of data if exists and returns inorder
+ *       successor of its node
+ * @param node tree pointer, nullptr for the root
+ * @param data data of node to remove
+ * @return BinaryNode<ItemType>* inorder successor of removed node, nullptr
+ *         if data is not in tree or the largest node was removed
+ */
+template <typename ItemType>
+BinaryNode<ItemType> *
+ThreadedBST<ItemType>::removeNode(BinaryNode<ItemType> *node,
+                                  const ItemType &data) {
+  TBST_TIMER(REMOVE);
+  if (filteredOut(data)) {
+    return nullptr;
+  }
+  if (node == nullptr) {
+    node = rootPtr;
+  }
+  BinaryNode<ItemType> *parent; // parent of removed node
+  BinaryNode<ItemType> *ptr = findNode(node, data, parent);
+  if (ptr != nullptr && ptr->getCount() == 0) {
+    ptr = liveNode(data);
+  }
+  if (ptr == nullptr) {
+    return nullptr;
+  }
+  // Tombstones are not compacted here, so the successor stays valid
+  if (ptr->getCount() > 1 || lazy) {
+    killCopies(ptr, 1);
+    return inorderSucc(ptr);
+  }
+  return removeFound(parent, ptr);
+}
+
+/**
+ * @brief Removes every node with given data
+ *
+ * @pre none
+ * @post no copy of given data is left in tree
+ * @param data data of nodes to remove
+ * @return int number of removed copies
+ */
+template <typename ItemType>
+int ThreadedBST<ItemType>::erase(const ItemType &data) {
+  TBST_TIMER(REMOVE);
+  int removed = 0;
+  if (filteredOut(data)) {
+    return removed;
+  }
+  BinaryNode<ItemType> *parent;
+  BinaryNode<ItemType> *ptr;
+  if (lazy) {
+    while ((ptr = liveNode(data)) != nullptr) {
+      removed += ptr->getCount();
+      killCopies(ptr, ptr->getCount());
+    }
+    checkTombstones();
+    return removed;
+  }
+  while ((ptr = findNode(rootPtr, data, parent)) != nullptr) {
+    removed += ptr->getCount();
+    removeFound(parent, ptr);
+  }
+  return removed;
+}
+
+/**
+ * @brief Removes one copy of given data and returns its item
+ *
+ * @pre none
+ * @post copy is removed if exists
+ * @param data data of node to remove
+ * @return optional<ItemType> removed item, empty if data is not in tree
+ */
+template <typename ItemType>
+optional<ItemType> ThreadedBST<ItemType>::extract(const ItemType &data) {
+  TBST_TIMER(REMOVE);
+  if (filteredOut(data)) {
+    return nullopt;
+  }
+  BinaryNode<ItemType> *parent;
+  BinaryNode<ItemType> *ptr = findNode(rootPtr, data, parent);
+  if (ptr != nullptr && ptr->getCount() == 0) {
+    ptr = liveNode(data);
+  }
+  if (ptr == nullptr) {
+    return nullopt;
+  }
+  optional<ItemType> item(ptr->getItem());
+  if (ptr->getCount() > 1 || lazy) {
+    killCopies(ptr, 1);
+    checkTombstones();
+  } else {
+    removeFound(parent, ptr);
+  }
+  return item;
+}
+
+/**
+ * @brief Find a node with given data
+ *
+ * @pre none
+ * @post returns iterator to node or end()
+ * @param data data to look for
+ * @return iterator position of data
+ */
+template <typename ItemType>
+typename ThreadedBST<ItemType>::iterator
+ThreadedBST<ItemType>::find(const ItemType &data) const {
+  TBST_TIMER(FIND);
+  if (filteredOut(data)) {
+    return end();
+  }
+  BinaryNode<ItemType> *parent;
+  BinaryNode<ItemType> *node = findNode(rootPtr, data, parent);
+  if (node != nullptr && node->getCount() == 0) {
+    node = liveNode(data);
+  }
+  return iterator(this, node);
+}
+
+/**
+ * @brief Find a node with given data, splaying it
+ *
+ * @pre none
+ * @post returns iterator to node or end(), the node reached is splayed
+ *       as the access mode says
+ * @param data data to look for
+ * @return iterator position of data
+ */
+template <typename ItemType>
+typename ThreadedBST<ItemType>::iterator
+ThreadedBST<ItemType>::find(const ItemType &data) {
+  if (access == ACCESS_STATIC) {
+    return as_const(*this).find(data);
+  }
+  TBST_TIMER(FIND);
+  if (filteredOut(data)) {
+    return end();
+  }
+  // Rotations keep every item in its node, so the iterator stays valid
+  return iterator(this, accessNode(data));
+}
+
+/**
+ * @brief Searches a group of keys in lockstep
+ *
+ * @pre size <= BATCH_LANES
+ * @post found holds the node of each key or nullptr
+ * @param keys keys to look for
+ * @param size number of keys
+ * @param found node found for each key
+ */
+template <typename ItemType>
+void ThreadedBST<ItemType>::findGroup(const ItemType *keys, size_t size,
+                                      BinaryNode<ItemType> **found) const {
+  BinaryNode<ItemType> *nodes[BATCH_LANES];
+  // Keys the filter rules out never start a search
+  bool active = false;
+  for (size_t i = 0; i < size; i++) {
+    nodes[i] = filteredOut(keys[i]) ? nullptr : rootPtr;
+    found[i] = nullptr;
+    active = active || nodes[i] != nullptr;
+  }
+
+  // Every search takes one step per round. The next node of each search is
+  // prefetched, so its miss overlaps with the steps of the other searches.
+  while (active) {
+    active = false;
+    for (size_t i = 0; i < size; i++) {
+      BinaryNode<ItemType> *node = nodes[i];
+      if (node == nullptr) {
+        continue;
+      }
+      TBST_STAT(NODES_VISITED);
+      const ItemType item = node->getItem();
+      BinaryNode<ItemType> *next;
+      TBST_STAT(COMPARISONS);
+      if (keys[i] < item) {
+        next = node->getLeftThread() ? nullptr : node->getLeftChildPtr();
+      } else if (item < keys[i]) {
+        TBST_STAT(COMPARISONS);
+        next = node->getRightThread() ? nullptr : node->getRightChildPtr();
+      } else {
+        TBST_STAT(COMPARISONS);
+        found[i] = node->getCount() > 0 ? node : liveNode(keys[i]);
+        next = nullptr;
+      }
+      nodes[i] = next;
+      if (next != nullptr) {
+#if defined(__GNUC__)
+        __builtin_prefetch(next);
+#endif
+        active = true;
+      }
+    }
+  }
+}
+
+/**
+ * @brief Find many keys, overlapping the cache misses of their searches
+ *
+ * @pre results has room for size iterators
+ * @post results holds the position of each key or end()
+ * @param keys keys to look for
+ * @param size number of keys
+ * @param results position found for each key
+ */
+template <typename ItemType>
+void ThreadedBST<ItemType>::findBatch(const ItemType *keys, size_t size,
+                                      iterator *results) const {
+  TBST_TIMER(FIND);
+  BinaryNode<ItemType> *found[BATCH_LANES];
+  for (size_t start = 0; start < size; start += BATCH_LANES) {
+    size_t group = min(BATCH_LANES, size - start);
+    findGroup(keys + start, group, found);
+    for (size_t i = 0; i < group; i++) {
+      results[start + i] = iterator(this, found[i]);
+    }
+  }
+}
+
+/**
+ * @brief Check many keys, overlapping the cache misses of their searches
+ *
+ * @pre results has room for size flags
+ * @post results holds if each key is in tree
+ * @param keys keys to look for
+ * @param size number of keys
+ * @param results true for each key found
+ */
+template <typename ItemType>
+void ThreadedBST<ItemType>::containsBatch(const ItemType *keys, size_t size,
+                                          bool *results) const {
+  TBST_TIMER(FIND);
+  BinaryNode<ItemType> *found[BATCH_LANES];
+  for (size_t start = 0; start < size; start += BATCH_LANES) {
+    size_t group = min(BATCH_LANES, size - start);
+    findGroup(keys + start, group, found);
+    for (size_t i = 0; i < group; i++) {
+      results[start + i] = found[i] != nullptr;
+    }
+  }
+}
+
+/**
+ * @brief Get iterator to the smallest node
+ *
+ * @pre none
+ * @post returns iterator to leftmost node
+ * @return iterator first position
+ */
+template <typename ItemType>
+typename ThreadedBST<ItemType>::iterator ThreadedBST<ItemType>::begin() const {
+  BinaryNode<ItemType> *node = getLeftMost(rootPtr);
+  while (node != nullptr && node->getCount() == 0) {
+    node = inorderSucc(node);
+  }
+  return iterator(this, node);
+}
+
+/**
+ * @brief Get iterator past the largest node
+ *
+ * @pre none
+ * @post returns end iterator
+ * @return iterator end position
+ */
+template <typename ItemType>
+typename ThreadedBST<ItemType>::iterator ThreadedBST<ItemType>::end() const {
+  return iterator(this, nullptr);
+}
+
+/**
+ * @brief Remove a node with no children
+ *
+ * @pre a node with no children
+ * @post removes node and returns inorder successor
+ * @param parent parent of removed node
+ * @param ptr pointer for removed node
+ * @return BinaryNode<ItemType>* inorder successor of removed node
+ */
+template <typename ItemType>
+BinaryNode<ItemType> *ThreadedBST<ItemType>::caseA(BinaryNode<ItemType> *parent,
+                                                   BinaryNode<ItemType> *ptr) {
+  TBST_STAT(REMOVE_CASE_A);
+  // Right pointer of a leaf is its successor thread, or nullptr if largest
+  BinaryNode<ItemType> *succ = ptr->getRightChildPtr();
+
+  // If node to be removed is rootPtr
+  if (parent == nullptr) {
+    rootPtr = nullptr;
+  }
+  // If node to be removed is left of its parent, parent takes its thread
+  else if (!(parent->getLeftThread()) && ptr == parent->getLeftChildPtr()) {
+    parent->setLeftChildPtr(ptr->getLeftChildPtr());
+    parent->setLeftThread(ptr->getLeftChildPtr() != nullptr);
+  } else {
+    parent->setRightChildPtr(ptr->getRightChildPtr());
+    parent->setRightThread(ptr->getRightChildPtr() != nullptr);
+  }
+
+  // Free memory and return inorder successor of removed node
+  deleteNode(ptr);
+  ptr = nullptr;
+  return succ;
+}
+
+/**
+ * @brief Remove a node with one child
+ *
+ * @pre a node with one child
+ * @post removes node and returns inorder successor
+ * @param parent parent of removed node
+ * @param ptr pointer for removed node
+ * @return BinaryNode<ItemType>* inorder successor of removed node
+ */
+template <typename ItemType>
+BinaryNode<ItemType> *ThreadedBST<ItemType>::caseB(BinaryNode<ItemType> *parent,
+                                                   BinaryNode<ItemType> *ptr) {
+  TBST_STAT(REMOVE_CASE_B);
+  BinaryNode<ItemType> *child;
+  BinaryNode<ItemType> *s;
+  BinaryNode<ItemType> *p;
+  // Checks if the node to be deleted has a left child.
+  // Its predecessor is the rightmost of that child and threads to ptr
+  if (ptr->getLeftThread() == false && ptr->getLeftChildPtr() != nullptr) {
+    child = ptr->getLeftChildPtr();
+    p = getRightMost(child);
+    s = ptr->getRightChildPtr();
+    p->setRightChildPtr(s);
+    p->setRightThread(s != nullptr);
+  }
+  // The node to be removed has a right child.
+  // Its successor is the leftmost of that child and threads to ptr
+  else {
+    child = ptr->getRightChildPtr();
+    s = getLeftMost(child);
+    p = ptr->getLeftChildPtr();
+    s->setLeftChildPtr(p);
+    s->setLeftThread(p != nullptr);
+  }
+  // if node to be removed is the tree root.
+  if (parent == nullptr) {
+    rootPtr = child;
+    // the node is the left child of its parent.
+  } else if (!(parent->getLeftThread()) && ptr == parent->getLeftChildPtr()) {
+    parent->setLeftChildPtr(child);
+  }
+  // the node is the right child of its parent.
+  else {
+    parent->setRightChildPtr(child);
+  }
+  // Free memory
+  deleteNode(ptr);
+  ptr = nullptr;
+  // return succesor
+  return s;
+}
+
+/**
+ * @brief Remove a node with two children
+ *
+ * @pre a node with two children
+ * @post removes node and returns inorder successor
+ * @param ptr pointer for removed node
+ * @return BinaryNode<ItemType>* inorder successor of removed node
+ */
+template <typename ItemType>
+BinaryNode<ItemType> *ThreadedBST<ItemType>::caseC(BinaryNode<ItemType> *ptr) {
+  TBST_STAT(REMOVE_CASE_C);
+  // Find inorder successor and its parent.
+  BinaryNode<ItemType> *parsucc = ptr;
+  BinaryNode<ItemType> *succ = ptr->getRightChildPtr();
+
+  // Find leftmost child of successor
+  while (succ->getLeftChildPtr() != nullptr && !(succ->getLeftThread())) {
+    parsucc = succ;
+    succ = succ->getLeftChildPtr();
+  }
+
+  // Successor item moves up, ptr now holds the inorder successor
+  ptr->setItem(succ->getItem());
+  ptr->setCount(succ->getCount());
+
+  if (succ->getRightThread() || succ->getRightChildPtr() == nullptr) {
+    caseA(parsucc, succ);
+  } else {
+    caseB(parsucc, succ);
+  }
+  return ptr;
+}
+
+/**
+ * @brief Returns inorder successor of node
+ *
+ * @pre none
+ * @post returns inorder successor of node
+ * @param ptr node to get inorder successor of
+ * @return BinaryNode<ItemType>* inorder successor of node
+ */
+template <typename ItemType>
+BinaryNode<ItemType> *
+ThreadedBST<ItemType>::inorderSucc(BinaryNode<ItemType> *ptr) const {
+  // If successor thread is found returns successor
+  if (ptr->getRightThread()) {
+    TBST_STAT(THREAD_FOLLOWS);
+    return ptr->getRightChildPtr();
+  }
+
+  // If successor contains a smaller left child node
+  // Returns left most child node of successor
+  TBST_STAT(CHILD_FOLLOWS);
+  ptr = getLeftMost(ptr->getRightChildPtr());
+  return ptr;
+}
+
+/**
+ * @brief Returns inorder predecessor of node
+ *
+ * @pre none
+ * @post returns inorder predecessor of node
+ * @param ptr node to get inorder predecessor of
+ * @return BinaryNode<ItemType>* inorder predecessor of node
+ */
+template <typename ItemType>
+BinaryNode<ItemType> *
+ThreadedBST<ItemType>::inorderPred(BinaryNode<ItemType> *ptr) const {
+  // If predessor thread is found returns predecessor
+  if (ptr->getLeftThread()) {
+    TBST_STAT(THREAD_FOLLOWS);
+    return ptr->getLeftChildPtr();
+  }
+
+  // If predecessor contains a larger right child node
+  // Returns right most child node of predecessor,
+  // nullptr if node is leftmost
+  TBST_STAT(CHILD_FOLLOWS);
+  ptr = getRightMost(ptr->getLeftChildPtr());
+  return ptr;
+}
+
+/**
+ * @brief Empty tree and deallocate memory
+ *
+ * @pre none
+ * @post tree is emptied and memory is deallocated
+ * @param node tree pointer
+ */
+template <typename ItemType>
+void ThreadedBST<ItemType>::clear(BinaryNode<ItemType> *node) {
+  size_t budget = SIZE_MAX;
+  clearSome(node, budget);
+}
+
+/**
+ * @brief Empty part of a tree within a work budget
+ *
+ * @pre none
+ * @post up to budget steps of clear are done, budget is decreased
+ * @param node tree pointer
+ * @param budget steps left
+ * @return BinaryNode<ItemType>* where to resume, nullptr when done
+ */
+template <typename ItemType>
+BinaryNode<ItemType> *
+ThreadedBST<ItemType>::clearSome(BinaryNode<ItemType> *node, size_t &budget) {
+  for (; node != nullptr && budget > 0; budget--) {
+    BinaryNode<ItemType> *left =
+        node->getLeftThread() ? nullptr : node->getLeftChildPtr();
+    if (left != nullptr) {
+      // Rotate the left child up so node ends up without a left subtree
+      node->setLeftChildPtr(left->getRightThread() ? nullptr
+                                                    : left->getRightChildPtr());
+      node->setLeftThread(false);
+      left->setRightChildPtr(node);
+      left->setRightThread(false);
+      node = left;
+    } else {
+      // No left subtree, delete node and continue with its right child
+      BinaryNode<ItemType> *right =
+          node->getRightThread() ? nullptr : node->getRightChildPtr();
+      deleteNode(node);
+      node = right;
+    }
+  }
+  return node;
+}
+
+/**
+ * @brief Deallocate a node from the heap or from a compacted block
+ *
+ * @pre node is detached
+ * @post node is destroyed and its memory freed or its slot released
+ * @param node node to delete
+ */
+template <typename ItemType>
+void ThreadedBST<ItemType>::deleteNode(BinaryNode<ItemType> *node) {
+  // A block is freed as a whole once no tree holds it
+  if (node->getInBlock()) {
+    node->~BinaryNode<ItemType>();
+  } else {
+    delete node;
+  }
+}
+
+/**
+ * @brief Get the next slot of a breadth first layout in inorder
+ *
+ * @pre 1 <= index <= size
+ * @post returns inorder successor slot
+ * @param index slot, counting from 1
+ * @param size number of slots
+ * @return size_t successor slot, 0 after the last
+ */
+template <typename ItemType>
+size_t ThreadedBST<ItemType>::breadthNext(size_t index, size_t size) {
+  // Leftmost slot of the right subtree
+  if (2 * index + 1 <= size) {
+    index = 2 * index + 1;
+    while (2 * index <= size) {
+      index = 2 * index;
+    }
+    return index;
+  }
+  // Otherwise climb while a right child, then the parent is next
+  while (index & 1) {
+    index >>= 1;
+  }
+  return index >> 1;
+}
+
+/**
+ * @brief Drop a compaction that has not been swapped in yet
+ *
+ * @pre none
+ * @post copied nodes are destroyed and their block freed
+ */
+template <typename ItemType> void ThreadedBST<ItemType>::abandonCompaction() {
+  if (!compaction.running) {
+    return;
+  }
+  if (compaction.block != nullptr) {
+    // Filled slots are the first ones in inorder
+    const size_t size = compaction.keys.size();
+    size_t index = 1;
+    while (2 * index <= size) {
+      index = 2 * index;
+    }
+    for (size_t i = 0; i < compaction.filled; i++) {
+      compaction.block.get()[index - 1].~BinaryNode<ItemType>();
+      index = breadthNext(index, size);
+    }
+    compaction.block.reset();
+  }
+  compaction.running = false;
+  compaction.cursor = nullptr;
+  compaction.keys = vector<pair<ItemType, int>>();
+  compaction.changes = vector<pair<ItemType, int>>();
+}
+
+/**
+ * @brief Checks if a running compaction has copied a node already
+ *
+ * @pre compaction is running, node is in tree
+ * @post returns if node comes before the copy cursor in inorder
+ * @param node node to check
+ * @return bool true if the copy will not read node again
+ */
+template <typename ItemType>
+bool ThreadedBST<ItemType>::copiedAlready(BinaryNode<ItemType> *node) const {
+  BinaryNode<ItemType> *cursor = compaction.cursor;
+  if (cursor == nullptr) {
+    return true;
+  }
+  if (node == cursor) {
+    return false;
+  }
+  const ItemType key = node->getItem();
+  const ItemType next = cursor->getItem();
+  if (key < next || next < key) {
+    return key < next;
+  }
+  // Equal keys, node was copied if the cursor comes later in their run
+  for (BinaryNode<ItemType> *later = inorderSucc(node);
+       later != nullptr && !(key < later->getItem());
+       later = inorderSucc(later)) {
+    if (later == cursor) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Tell a running compaction that copies of a node changed
+ *
+ * @pre node is in tree, called before a removal changes it
+ * @post change is kept for the compacted tree if its copy missed it
+ * @param node node that gained or lost copies
+ * @param copies copies added, negative if removed
+ */
+template <typename ItemType>
+void ThreadedBST<ItemType>::noteChange(BinaryNode<ItemType> *node,
+                                       int copies) {
+  // Changes ahead of the cursor are read by the copy itself
+  if (compaction.running && copies != 0 && copiedAlready(node)) {
+    compaction.changes.emplace_back(node->getItem(), copies);
+  }
+}
+
+/**
+ * @brief Add or remove copies of a key without a lookup filter update
+ *
+ * @pre removed copies are in tree
+ * @post tree holds copies more of data, fewer if negative
+ * @param data key to change
+ * @param copies copies to add, negative to remove
+ */
+template <typename ItemType>
+void ThreadedBST<ItemType>::applyChange(const ItemType &data, int copies) {
+  // The filters saw this change when it first happened
+  const bool wasFiltered = filtered;
+  filtered = false;
+  for (; copies > 0; copies--) {
+    add(nullptr, data);
+  }
+  while (copies < 0) {
+    BinaryNode<ItemType> *node = liveNode(data);
+    const int taken = min(node->getCount(), -copies);
+    if (taken < node->getCount()) {
+      node->setCount(node->getCount() - taken);
+    } else {
+      removeFound(parentOf(node), node);
+    }
+    copies += taken;
+  }
+  filtered = wasFiltered;
+}
+
+/**
+ * @brief Delete the nodes the last compaction replaced within a budget
+ *
+ * @pre none
+ * @post up to budget old nodes are deleted, their blocks released once
+ *       all are gone
+ * @param budget steps left
+ * @return bool true once no old node is left
+ */
+template <typename ItemType>
+bool ThreadedBST<ItemType>::retireSome(size_t &budget) {
+  compaction.retired = clearSome(compaction.retired, budget);
+  if (compaction.retired != nullptr) {
+    return false;
+  }
+  compaction.retiredBlocks.clear();
+  return true;
+}
+
+/**
+ * @brief Rotates a node above its parent
+ *
+ * @pre child is a child of parent, parent is a child of grand or the
+ *      root when grand is nullptr
+ * @post child takes the place of parent, threads are kept
+ * @param child node to move up
+ * @param parent node to move down
+ * @param grand parent of parent or nullptr
+ */
+template <typename ItemType>
+void ThreadedBST<ItemType>::rotateUp(BinaryNode<ItemType> *child,
+                                     BinaryNode<ItemType> *parent,
+                                     BinaryNode<ItemType> *grand) {
+  if (!(parent->getLeftThread()) && parent->getLeftChildPtr() == child) {
+    // Right rotation. Without a right subtree the right pointer of child
+    // is its successor thread to parent, which parent turns around into
+    // a predecessor thread.
+    if (child->getRightThread()) {
+      parent->setLeftChildPtr(child);
+      parent->setLeftThread(true);
+    } else {
+      parent->setLeftChildPtr(child->getRightChildPtr());
+    }
+    child->setRightChildPtr(parent);
+    child->setRightThread(false);
+  } else {
+    // Left rotation, the mirror image
+    if (child->getLeftThread()) {
+      parent->setRightChildPtr(child);
+      parent->setRightThread(true);
+    } else {
+      parent->setRightChildPtr(child->getLeftChildPtr());
+    }
+    child->setLeftChildPtr(parent);
+    child->setLeftThread(false);
+  }
+
+  if (grand == nullptr) {
+    rootPtr = child;
+  } else if (!(grand->getLeftThread()) && grand->getLeftChildPtr() == parent) {
+    grand->setLeftChildPtr(child);
+  } else {
+    grand->setRightChildPtr(child);
+  }
+}
+
+/**
+ * @brief Splays the last node of accessPath
+ *
+ * @pre accessPath holds the nodes from the root down to the node
+ * @post node is moved up as the access mode says
+ */
+template <typename ItemType> void ThreadedBST<ItemType>::splayPath() {
+  size_t depth = accessPath.size() - 1;
+  if (depth < (size_t)splayMinDepth) {
+    return;
+  }
+  BinaryNode<ItemType> *node = accessPath[depth];
+  while (depth > 0) {
+    BinaryNode<ItemType> *parent = accessPath[depth - 1];
+    // Zig, parent is the root
+    if (depth == 1) {
+      rotateUp(node, parent, nullptr);
+      break;
+    }
+    BinaryNode<ItemType> *grand = accessPath[depth - 2];
+    BinaryNode<ItemType> *above = depth > 2 ? accessPath[depth - 3] : nullptr;
+    bool nodeLeft =
+        !(parent->getLeftThread()) && parent->getLeftChildPtr() == node;
+    bool parentLeft =
+        !(grand->getLeftThread()) && grand->getLeftChildPtr() == parent;
+    if (nodeLeft == parentLeft) {
+      // Zig-zig, lift parent first
+      rotateUp(parent, grand, above);
+      if (access == ACCESS_SEMI_SPLAY) {
+        // Semi-splay carries on from parent, node stays below it
+        node = parent;
+      } else {
+        rotateUp(node, parent, above);
+      }
+    } else {
+      // Zig-zag, node goes up twice
+      rotateUp(node, parent, grand);
+      rotateUp(node, grand, above);
+    }
+    depth -= 2;
+    accessPath[depth] = node;
+  }
+  // A splay pushes any node at most two levels down
+  height = min(height + 2, count);
+}
+
+/**
+ * @brief Search that splays the node it reaches
+ *
+ * @pre none
+ * @post node with data or the last node visited is splayed
+ * @param data data to look for
+ * @return BinaryNode<ItemType>* node with data or nullptr
+ */
+template <typename ItemType>
+BinaryNode<ItemType> *ThreadedBST<ItemType>::accessNode(const ItemType &data) {
+  accessPath.clear();
+  BinaryNode<ItemType> *node = rootPtr;
+  BinaryNode<ItemType> *found = nullptr;
+  while (node != nullptr) {
+    TBST_STAT(NODES_VISITED);
+    accessPath.push_back(node);
+    if (data < node->getItem()) {
+      TBST_STAT(COMPARISONS);
+      node = node->getLeftThread() ? nullptr : node->getLeftChildPtr();
+    } else if (node->getItem() < data) {
+      TBST_STAT_ADD(COMPARISONS, 2);
+      node = node->getRightThread() ? nullptr : node->getRightChildPtr();
+    } else {
+      TBST_STAT_ADD(COMPARISONS, 2);
+      found = node->getCount() > 0 ? node : liveNode(data);
+      break;
+    }
+  }
+  // A miss splays the last node visited, a neighbour of data
+  if (!accessPath.empty()) {
+    splayPath();
+  }
+  return found;
+}
+
+/**
+ * @brief Find a node with given data that is not a tombstone
+ *
+ * @pre none
+ * @post returns first live node with data in inorder or nullptr
+ * @param data data to look for
+ * @return BinaryNode<ItemType>* live node with data
+ */
+template <typename ItemType>
+BinaryNode<ItemType> *
+ThreadedBST<ItemType>::liveNode(const ItemType &data) const {
+  // Duplicates can sit on either side of a tombstone after rotations or
+  // compaction, the lower bound skips tombstones in inorder
+  BinaryNode<ItemType> *node = lowerBound(data);
+  if (node == nullptr || data < node->getItem()) {
+    return nullptr;
+  }
+  return node;
+}
+
+/**
+ * @brief Takes copies from a node, leaving a tombstone when none are left
+ *
+ * @pre node is live and in tree, copies <= its count
+ * @post node has copies fewer, a tombstone once none are left
+ * @param node node to take a copy from
+ * @param copies copies to take
+ */
+template <typename ItemType>
+void ThreadedBST<ItemType>::killCopies(BinaryNode<ItemType> *node,
+                                       int copies) {
+  noteChange(node, -copies);
+  node->setCount(node->getCount() - copies);
+  if (node->getCount() == 0) {
+    dead++;
+    filterRemove(1);
+  }
+}
+
+/**
+ * @brief Compact if tombstones passed their limit
+ *
+ * @pre none
+ * @post tombstones are at most maxDeadFraction of the nodes
+ */
+template <typename ItemType> void ThreadedBST<ItemType>::checkTombstones() {
+  if (dead > 0 && dead > maxDeadFraction * count) {
+    purgeTombstones();
+  }
+}
+
+/**
+ * @brief Compact until no tombstones are left
+ *
+ * @pre none
+ * @post tree has no tombstones
+ */
+template <typename ItemType> void ThreadedBST<ItemType>::purgeTombstones() {
+  // The first call may only finish deleting the nodes an earlier
+  // compaction replaced
+  while (!compact() || dead > 0) {
+  }
+}
+
+/**
+ * @brief Rebuild the filters from the live keys of the tree
+ *
+ * @pre none
+ * @post filters hold every live key of the tree if they are on
+ */
+template <typename ItemType> void ThreadedBST<ItemType>::rebuildFilter() {
+  if (!filtered) {
+    return;
+  }
+  // Leave room for the tree to double before the next rebuild
+  filterCapacity = max((size_t)(count - dead) * 2, (size_t)64);
+  keyFilter.reset(filterCapacity, filterBitsPerKey);
+  if (filterPrefixBits > 0) {
+    rangeFilter.reset(filterCapacity, filterBitsPerKey);
+  }
+  filterKeys = 0;
+  filterRemoved = 0;
+  for (BinaryNode<ItemType> *node = getLeftMost(rootPtr); node != nullptr;
+       node = inorderSucc(node)) {
+    if (node->getCount() > 0) {
+      keyFilter.add(node->getItem());
+      if (filterPrefixBits > 0) {
+        rangeFilter.add(prefixOf(node->getItem()));
+      }
+      filterKeys++;
+    }
+  }
+}
+
+/**
+ * @brief Add a key to the filters
+ *
+ * @pre none
+ * @post key is in the filters if they are on, rebuilt first if full
+ * @param data key to add
+ */
+template <typename ItemType>
+void ThreadedBST<ItemType>::filterAdd(const ItemType &data) {
+  if (!filtered) {
+    return;
+  }
+  // An overfull filter passes too many missing keys, start over from
+  // the tree, which does not hold data yet
+  if (filterKeys >= filterCapacity) {
+    rebuildFilter();
+  }
+  keyFilter.add(data);
+  if (filterPrefixBits > 0) {
+    rangeFilter.add(prefixOf(data));
+  }
+  filterKeys++;
+}
+
+/**
+ * @brief Count keys removed from the tree against the filters
+ *
+ * @pre none
+ * @post filters are rebuilt once removed keys make up half of them
+ * @param removed keys removed
+ */
+template <typename ItemType>
+void ThreadedBST<ItemType>::filterRemove(size_t removed) {
+  if (!filtered) {
+    return;
+  }
+  // Removed keys stay in the filters as false positives until a rebuild
+  filterRemoved += removed;
+  if (2 * filterRemoved > filterKeys) {
+    rebuildFilter();
+  }
+}
+
+/**
+ * @brief Take over the filters of another tree
+ *
+ * @pre filters of from hold every live key of tree, tree is whole
+ * @post tree uses them with foreign keys counted as removed and from
+ *       needs a rebuild, unless filter settings differ or either is off
+ * @param from tree whose filters are taken, may be tree itself
+ * @param foreign keys in them that tree does not hold
+ * @return bool true if taken
+ */
+template <typename ItemType>
+bool ThreadedBST<ItemType>::takeFilter(ThreadedBST<ItemType> &from,
+                                       size_t foreign) {
+  if (!filtered || !from.filtered || from.filterCapacity == 0 ||
+      filterBitsPerKey != from.filterBitsPerKey ||
+      filterPrefixBits != from.filterPrefixBits) {
+    return false;
+  }
+  if (&from != this) {
+    keyFilter = move(from.keyFilter);
+    rangeFilter = move(from.rangeFilter);
+    filterCapacity = from.filterCapacity;
+    filterKeys = from.filterKeys;
+    filterRemoved = from.filterRemoved;
+    from.filterCapacity = 0;
+  }
+  filterRemove(foreign);
+  return true;
+}
+
+/**
+ * @brief Checks if the filter rules a key out
+ *
+ * @pre none
+ * @post returns true only if data is not in tree
+ * @param data data to look for
+ * @return bool true if data is surely missing
+ */
+template <typename ItemType>
+bool ThreadedBST<ItemType>::filteredOut(const ItemType &data) const {
+  return filtered && !keyFilter.mayContain(data);
+}
+
+/**
+ * @brief Get range filter entry of an integer key
+ *
+ * @pre ItemType is an integer type
+ * @post return key prefix, in the same order as keys
+ * @param data key to map
+ * @return uint64_t key prefix
+ */
+template <typename ItemType>
+uint64_t ThreadedBST<ItemType>::prefixOf(const ItemType &data) const {
+  if constexpr (is_integral<ItemType>::value) {
+    uint64_t bits = (uint64_t)(int64_t)data;
+    // Flip the sign bit so negative keys come before the others
+    if (is_signed<ItemType>::value) {
+      bits ^= 1ULL << 63;
+    }
+    return bits >> filterPrefixBits;
+  } else {
+    return 0;
+  }
+}
+
+/**
+ * @brief Rebalance tree and move it into one contiguous block
+ *
+ * @pre none
+ * @post live keys are copied in inorder and rebuilt as a complete
+ *       tree laid out breadth first, threads are rewired and the old
+ *       nodes deleted. Changes between slices to keys already copied
+ *       are replayed on the new tree, so adding and removing keeps
+ *       the copy going instead of restarting it.
+ * @param budget nodes to handle in this slice, 0 for no limit
+ * @return bool true once compaction is complete
+ */
+template <typename ItemType>
+bool ThreadedBST<ItemType>::compact(size_t budget) {
+  if (budget == 0) {
+    budget = SIZE_MAX;
+  }
+
+  // Finish deleting the nodes a previous compaction replaced, that
+  // compaction is complete once they are gone
+  if (compaction.retired != nullptr) {
+    return retireSome(budget);
+  }
+  if (!compaction.running) {
+    if (count == 0) {
+      return true;
+    }
+    // Nothing but tombstones, delete them all
+    if (count == dead) {
+      compaction.retired = rootPtr;
+      compaction.retiredBlocks = move(blocks);
+      blocks.clear();
+      rootPtr = nullptr;
+      count = 0;
+      dead = 0;
+      height = 0;
+      return retireSome(budget);
+    }
+    compaction.running = true;
+    compaction.keys.reserve(count - dead);
+    compaction.cursor = getLeftMost(rootPtr);
+  }
+
+  // Copy the live keys in inorder. Later changes behind the cursor are
+  // noted by noteChange, the ones ahead of it are read here.
+  for (; compaction.cursor != nullptr && budget > 0; budget--) {
+    if (compaction.cursor->getCount() > 0) {
+      compaction.keys.emplace_back(compaction.cursor->getItem(),
+                                   compaction.cursor->getCount());
+    }
+    compaction.cursor = inorderSucc(compaction.cursor);
+  }
+  if (compaction.cursor != nullptr) {
+    return false;
+  }
+
+  // Lay the copied keys out in the breadth first slots of a complete
+  // tree, so children of slot i are slots 2i and 2i + 1
+  const size_t size = compaction.keys.size();
+  if (compaction.block == nullptr && size > 0) {
+    compaction.block = shared_ptr<BinaryNode<ItemType>>(
+        static_cast<BinaryNode<ItemType> *>(
+            ::operator new(size * sizeof(BinaryNode<ItemType>))),
+        [](BinaryNode<ItemType> *slots) { ::operator delete(slots); });
+    compaction.index = 1;
+    while (2 * compaction.index <= size) {
+      compaction.index = 2 * compaction.index;
+    }
+    compaction.prev = 0;
+    compaction.filled = 0;
+  }
+  BinaryNode<ItemType> *slots =
+      size > 0 ? compaction.block.get() - 1 : nullptr;
+  for (; compaction.filled < size && budget > 0; budget--) {
+    const pair<ItemType, int> &key = compaction.keys[compaction.filled];
+    const size_t i = compaction.index;
+    BinaryNode<ItemType> *node =
+        new (&slots[i]) BinaryNode<ItemType>(key.first);
+    node->setCount(key.second);
+    node->setInBlock(true);
+    if (2 * i <= size) {
+      node->setLeftChildPtr(&slots[2 * i]);
+    } else if (compaction.prev != 0) {
+      node->setLeftChildPtr(&slots[compaction.prev]);
+      node->setLeftThread(true);
+    }
+    if (2 * i + 1 <= size) {
+      node->setRightChildPtr(&slots[2 * i + 1]);
+    }
+    // Previous slot without a right child threads to this one
+    if (compaction.prev != 0 && 2 * compaction.prev + 1 > size) {
+      slots[compaction.prev].setRightChildPtr(node);
+      slots[compaction.prev].setRightThread(true);
+    }
+    compaction.prev = i;
+    compaction.index = breadthNext(i, size);
+    compaction.filled++;
+  }
+  if (compaction.filled < size) {
+    return false;
+  }
+
+  // Swap the copy in and start deleting the old nodes
+  compaction.retired = rootPtr;
+  compaction.retiredBlocks = move(blocks);
+  blocks.clear();
+  rootPtr = nullptr;
+  if (size > 0) {
+    rootPtr = compaction.block.get();
+    blocks.push_back(move(compaction.block));
+  }
+  compaction.block.reset();
+  count = (int)size;
+  dead = 0;
+  height = 0;
+  for (size_t levels = size; levels > 0; levels >>= 1) {
+    height++;
+  }
+  // Replay what changed behind the cursor while copying
+  vector<pair<ItemType, int>> changes = move(compaction.changes);
+  compaction.running = false;
+  compaction.cursor = nullptr;
+  compaction.keys = vector<pair<ItemType, int>>();
+  compaction.changes = vector<pair<ItemType, int>>();
+  for (const pair<ItemType, int> &change : changes) {
+    applyChange(change.first, change.second);
+  }
+  return retireSome(budget);
+}
+
+// gets the leftmost node in the threaded BST
+// Returns the leftmost node in the tree
+/**
+ * @brief Get the leftmost node of given tree
+ *
+ * @pre none
+ * @post returns leftmost node
+ * @param node tree pointer
+ * @return BinaryNode<ItemType>* leftmode node
+ */
+template <typename ItemType>
+BinaryNode<ItemType> *
+ThreadedBST<ItemType>::getLeftMost(BinaryNode<ItemType> *node) const {
+  // Node is empty
+  if (node == nullptr) {
+    // Returns empty node
+    return nullptr;
+  }
+  // While there is a possible left child to access
+  // Checks if left child node is a thread or already left most of tree
+  while (node->getLeftChildPtr() != nullptr && !(node->getLeftThread())) {
+    // Iterates to left child ptr
+    node = node->getLeftChildPtr();
+  }
+  // Returns left most node
+  return node;
+}
+
+/**
+ * @brief Get the rightmost node of given tree
+ *
+ * @pre none
+ * @post returns rightmost node
+ * @param node tree pointer
+ * @return BinaryNode<ItemType>* rightmode node
+ */
+template <typename ItemType>
+BinaryNode<ItemType> *
+ThreadedBST<ItemType>::getRightMost(BinaryNode<ItemType> *node) const {
+  if (node == nullptr) {
+    return nullptr;
+  }
+  while (node->getRightChildPtr() != nullptr && !(node->getRightThread())) {
+    node = node->getRightChildPtr();
+  }
+  return node;
+}
+
+/**
+ * @brief Set tree threads
+ *
+ * @pre none
+ * @post tree turns into ThreadedBST
+ * @param node tree pointer
+ */
+template <typename ItemType>
+void ThreadedBST<ItemType>::setThread(BinaryNode<ItemType> *node) {
+  if (node == nullptr) {
+    return;
+  }
+  // Rightmost node has no successor
+  BinaryNode<ItemType> *last = getRightMost(node);
+  last->setRightChildPtr(nullptr);
+  last->setRightThread(false);
+
+  // Morris traversal, the temporary links it makes are the right threads
+  BinaryNode<ItemType> *prev = nullptr;
+  while (node != nullptr) {
+    BinaryNode<ItemType> *left =
+        node->getLeftThread() ? nullptr : node->getLeftChildPtr();
+    if (left != nullptr) {
+      BinaryNode<ItemType> *pred = getRightMost(left);
+      // Left subtree not visited yet unless we just came back from it
+      if (!(pred->getRightThread() && pred->getRightChildPtr() == node &&
+            pred == prev)) {
+        pred->setRightChildPtr(node);
+        pred->setRightThread(true);
+        node = left;
+        continue;
+      }
+    } else {
+      node->setLeftChildPtr(prev);
+      node->setLeftThread(prev != nullptr);
+    }
+    prev = node;
+    node = node->getRightChildPtr();
+  }
+}
+
+/**
+ * @brief Remove even nodes
+ *
+ * @pre none
+ * @post tree with odd nodes
+ */
+template <typename ItemType> void ThreadedBST<ItemType>::removeEven() {
+  TBST_TIMER(REMOVE);
+  BinaryNode<ItemType> *node =
+      getLeftMost(rootPtr); // traverses through tree (inorder)
   BinaryNode<ItemType> *temp;
-  while (node != nullptr) {           // if current position can move right
-    if ((node->getItem() % 2) == 0) { // current position has even value
-      temp = removeNode(rootPtr, node->getItem()); // removes even value node
+  while (node != nullptr) { // if current position can move right
+    // current position has even value and is not a tombstone
+    if (node->getCount() > 0 && (node->getItem() % 2) == 0) {
+      if (lazy) {
+        // Bury this node itself, a search by key could find an equal one
+        killCopies(node, node->getCount());
+        temp = inorderSucc(node);
+      } else {
+        // Unlink this node itself, a search by key could find an equal one
+        temp = removeFound(parentOf(node), node);
+      }
     } else {
       temp = inorderSucc(node);
     }
     node = nullptr;
     node = temp;
   }
+  checkTombstones();
+}
+
+/**
+ * @brief Splits a threaded subtree around a key
+ *
+ * @pre node is a threaded subtree with no threads leaving it
+ * @post lower holds nodes less than key, upper holds the rest
+ * @param node subtree pointer
+ * @param key key to split around
+ * @param lower root of subtree with nodes less than key
+ * @param upper root of subtree with nodes not less than key
+ */
+template <typename ItemType>
+void ThreadedBST<ItemType>::splitNodes(BinaryNode<ItemType> *node,
+                                       const ItemType &key,
+                                       BinaryNode<ItemType> *&lower,
+                                       BinaryNode<ItemType> *&upper) {
+  lower = nullptr;
+  upper = nullptr;
+  // Largest node of lower so far, the next lower node hangs off its right
+  BinaryNode<ItemType> *lowerTail = nullptr;
+  // Smallest node of upper so far, the next upper node hangs off its left
+  BinaryNode<ItemType> *upperTail = nullptr;
+
+  // Walk the search path of key, handing each node to one side
+  while (node != nullptr) {
+    if (node->getItem() < key) {
+      if (lowerTail == nullptr) {
+        lower = node;
+      } else {
+        lowerTail->setRightChildPtr(node);
+        lowerTail->setRightThread(false);
+      }
+      lowerTail = node;
+      node = node->getRightThread() ? nullptr : node->getRightChildPtr();
+    } else {
+      if (upperTail == nullptr) {
+        upper = node;
+      } else {
+        upperTail->setLeftChildPtr(node);
+        upperTail->setLeftThread(false);
+      }
+      upperTail = node;
+      node = node->getLeftThread() ? nullptr : node->getLeftChildPtr();
+    }
+  }
+
+  // Threads crossing the split point now lead out of the subtree
+  if (lowerTail != nullptr) {
+    lowerTail->setRightChildPtr(nullptr);
+    lowerTail->setRightThread(false);
+  }
+  if (upperTail != nullptr) {
+    upperTail->setLeftChildPtr(nullptr);
+    upperTail->setLeftThread(false);
+  }
+}
+
+/**
+ * @brief Joins two threaded subtrees under a middle node
+ *
+ * @pre lower < mid <= upper, mid is detached
+ * @post threaded subtree rooted at mid is returned
+ * @param lower subtree with smaller nodes
+ * @param mid node to become the root
+ * @param upper subtree with larger nodes
+ * @return BinaryNode<ItemType>* root of joined subtree
+ */
+template <typename ItemType>
+BinaryNode<ItemType> *
+ThreadedBST<ItemType>::joinNodes(BinaryNode<ItemType> *lower,
+                                 BinaryNode<ItemType> *mid,
+                                 BinaryNode<ItemType> *upper) {
+  // Rightmost of lower now threads to mid
+  if (lower != nullptr) {
+    BinaryNode<ItemType> *pred = getRightMost(lower);
+    pred->setRightChildPtr(mid);
+    pred->setRightThread(true);
+  }
+  // Leftmost of upper now threads to mid
+  if (upper != nullptr) {
+    BinaryNode<ItemType> *succ = getLeftMost(upper);
+    succ->setLeftChildPtr(mid);
+    succ->setLeftThread(true);
+  }
+  mid->setLeftChildPtr(lower);
+  mid->setLeftThread(false);
+  mid->setRightChildPtr(upper);
+  mid->setRightThread(false);
+  return mid;
+}
+
+/**
+ * @brief Joins two threaded subtrees
+ *
+ * @pre every node of lower <= every node of upper
+ * @post threaded subtree holding both is returned
+ * @param lower subtree with smaller nodes
+ * @param upper subtree with larger nodes
+ * @return BinaryNode<ItemType>* root of joined subtree
+ */
+template <typename ItemType>
+BinaryNode<ItemType> *
+ThreadedBST<ItemType>::joinNodes(BinaryNode<ItemType> *lower,
+                                 BinaryNode<ItemType> *upper) {
+  if (lower == nullptr) {
+    return upper;
+  }
+  if (upper == nullptr) {
+    return lower;
+  }
+  // Leftmost of upper becomes the root between both subtrees
+  BinaryNode<ItemType> *mid = detachMin(upper);
+  return joinNodes(lower, mid, upper);
+}
+
+/**
+ * @brief Detaches the leftmost node of a threaded subtree
+ *
+ * @pre node is not empty
+ * @post leftmost node is unlinked and node is updated to the new root
+ * @param node subtree pointer
+ * @return BinaryNode<ItemType>* detached node
+ */
+template <typename ItemType>
+BinaryNode<ItemType> *
+ThreadedBST<ItemType>::detachMin(BinaryNode<ItemType> *&node) {
+  BinaryNode<ItemType> *parent = nullptr;
+  BinaryNode<ItemType> *min = node;
+  while (min->getLeftChildPtr() != nullptr && !(min->getLeftThread())) {
+    parent = min;
+    min = min->getLeftChildPtr();
+  }
+
+  // Right subtree of min takes its place
+  BinaryNode<ItemType> *rest =
+      min->getRightThread() ? nullptr : min->getRightChildPtr();
+  if (parent == nullptr) {
+    node = rest;
+  } else {
+    parent->setLeftChildPtr(rest);
+    parent->setLeftThread(false);
+  }
+
+  // New leftmost node no longer has a predecessor
+  if (rest != nullptr) {
+    BinaryNode<ItemType> *first = getLeftMost(rest);
+    first->setLeftChildPtr(nullptr);
+    first->setLeftThread(false);
+  }
+
+  min->setLeftChildPtr(nullptr);
+  min->setLeftThread(false);
+  min->setRightChildPtr(nullptr);
+  min->setRightThread(false);
+  return min;
+}
+
+/**
+ * @brief Union, intersection or difference of a subtree with a read-only
+ *        subtree
+ *
+ * @pre node is a threaded subtree with no threads leaving it
+ * @post subtree holding the result is returned, nodes that drop out are
+ *       deleted
+ * @param node subtree to change
+ * @param other subtree whose keys are combined with node
+ * @param operation set operation to apply
+ * @param changed incremented for every node added, kept or deleted as
+ *        union, intersection or difference counts them
+ * @return BinaryNode<ItemType>* root of the resulting subtree
+ */
+template <typename ItemType>
+BinaryNode<ItemType> *
+ThreadedBST<ItemType>::combineNodes(BinaryNode<ItemType> *node,
+                                    BinaryNode<ItemType> *other,
+                                    SetOperation operation, int &changed) {
+  // Each node of other splits node around its key, the key is settled in
+  // the middle, the halves are combined with the subtrees of other and the
+  // results are joined again. The pending calls are kept on a stack
+  // instead of the call stack, as other may be as deep as it is large.
+  struct Frame {
+    BinaryNode<ItemType> *other; // Node of other this call handles
+    BinaryNode<ItemType> *mid;   // Node kept for its key or nullptr
+    BinaryNode<ItemType> *lower; // Left half, combined once done
+    BinaryNode<ItemType> *upper; // Right half, combined last
+    bool leftDone;               // Left half has been combined
+  };
+  vector<Frame> frames;
+  BinaryNode<ItemType> *result = nullptr; // Result of the last call
+  bool calling = true;
+
+  while (true) {
+    if (calling) {
+      // Nothing left to take keys from, or nothing to take them away from
+      if (other == nullptr || (node == nullptr && operation != SET_UNION)) {
+        if (operation == SET_INTERSECTION) {
+          clear(node);
+          node = nullptr;
+        }
+        result = node;
+        calling = false;
+        continue;
+      }
+      const ItemType key = other->getItem();
+      BinaryNode<ItemType> *lower;
+      BinaryNode<ItemType> *upper;
+      splitNodes(node, key, lower, upper);
+
+      BinaryNode<ItemType> *first = upper ? getLeftMost(upper) : nullptr;
+      const bool match = first != nullptr && first->getItem() == key;
+      BinaryNode<ItemType> *mid = nullptr;
+      if (operation == SET_UNION) {
+        // Reuse the matching node if present, otherwise copy the key unless
+        // it is a tombstone of other
+        if (match) {
+          mid = detachMin(upper);
+          mid->setCount(max(mid->getCount(), other->getCount()));
+        } else if (other->getCount() > 0) {
+          mid = new BinaryNode<ItemType>(key);
+          mid->setCount(other->getCount());
+          filterAdd(key);
+          changed++;
+        }
+      } else if (operation == SET_INTERSECTION) {
+        if (match) {
+          mid = detachMin(upper);
+          // A tombstone of other counts as missing
+          if (other->getCount() == 0) {
+            deleteNode(mid);
+            mid = nullptr;
+          } else {
+            mid->setCount(min(mid->getCount(), other->getCount()));
+            changed++;
+          }
+        }
+      } else if (match) {
+        // Counted copies are taken away, the node goes with the last one
+        if (first->getCount() > other->getCount()) {
+          first->setCount(first->getCount() - other->getCount());
+        } else {
+          deleteNode(detachMin(upper));
+          changed++;
+        }
+      }
+
+      frames.push_back(Frame{other, mid, nullptr, upper, false});
+      node = lower;
+      other = other->getLeftThread() ? nullptr : other->getLeftChildPtr();
+      continue;
+    }
+
+    // A call returned result to the frame below it
+    if (frames.empty()) {
+      return result;
+    }
+    Frame &frame = frames.back();
+    if (!frame.leftDone) {
+      frame.lower = result;
+      frame.leftDone = true;
+      node = frame.upper;
+      other = frame.other->getRightThread()
+                  ? nullptr
+                  : frame.other->getRightChildPtr();
+      calling = true;
+      continue;
+    }
+    result = (frame.mid == nullptr)
+                 ? joinNodes(frame.lower, result)
+                 : joinNodes(frame.lower, frame.mid, result);
+    frames.pop_back();
+  }
+}
+
+/**
+ * @brief Adds a new node as the left child of a threaded node
+ *
+ * @pre parent has no left child
+ * @post new node is the left child of parent with threads set
+ * @param parent node to attach to
+ * @param data data of new node
+ * @return BinaryNode<ItemType>* pointer to new node
+ */
+template <typename ItemType>
+BinaryNode<ItemType> *
+ThreadedBST<ItemType>::attachLeft(BinaryNode<ItemType> *parent,
+                                  const ItemType &data) {
+  BinaryNode<ItemType> *node = new BinaryNode<ItemType>(data);
+  // New node takes over the predecessor thread of parent
+  node->setLeftChildPtr(parent->getLeftChildPtr());
+  node->setLeftThread(parent->getLeftThread());
+  node->setRightChildPtr(parent);
+  node->setRightThread(true);
+  parent->setLeftChildPtr(node);
+  parent->setLeftThread(false);
+  return node;
+}
+
+/**
+ * @brief Adds a new node as the right child of a threaded node
+ *
+ * @pre parent has no right child
+ * @post new node is the right child of parent with threads set
+ * @param parent node to attach to
+ * @param data data of new node
+ * @return BinaryNode<ItemType>* pointer to new node
+ */
+template <typename ItemType>
+BinaryNode<ItemType> *
+ThreadedBST<ItemType>::attachRight(BinaryNode<ItemType> *parent,
+                                   const ItemType &data) {
+  BinaryNode<ItemType> *node = new BinaryNode<ItemType>(data);
+  // New node takes over the successor thread of parent
+  node->setRightChildPtr(parent->getRightChildPtr());
+  node->setRightThread(parent->getRightThread());
+  node->setLeftChildPtr(parent);
+  node->setLeftThread(true);
+  parent->setRightChildPtr(node);
+  parent->setRightThread(false);
+  return node;
+}
+
+/**
+ * @brief Splits tree into nodes less than key and the rest. Cutting
+ *        follows one search path and counting walks the smaller side,
+ *        so a split takes O(height + smaller side) steps. The larger
+ *        side keeps the filters, unless its filter settings differ.
+ *
+ * @pre none
+ * @post tree is empty unless it is lower or upper, lower and upper are
+ *       threaded trees with its duplicate mode and lazy deletion
+ *       settings, their previous nodes are deleted
+ * @param key key to split around
+ * @param lower tree for nodes less than key
+ * @param upper tree for nodes not less than key
+ */
+template <typename ItemType>
+void ThreadedBST<ItemType>::split(const ItemType &key,
+                                  ThreadedBST<ItemType> &lower,
+                                  ThreadedBST<ItemType> &upper) {
+  abandonCompaction();
+  lower.abandonCompaction();
+  upper.abandonCompaction();
+  BinaryNode<ItemType> *node = rootPtr;
+  int total = count;
+  int totalDead = dead;
+  rootPtr = nullptr;
+  count = 0;
+  dead = 0;
+  const int totalHeight = height;
+  height = 0;
+  clear(lower.rootPtr);
+  clear(upper.rootPtr);
+  // Both sides are at most as tall as the whole tree, and store
+  // duplicates and removals the way it did
+  for (ThreadedBST<ItemType> *side : {&lower, &upper}) {
+    side->height = totalHeight;
+    side->multiset = multiset;
+    side->lazy = lazy;
+    side->maxDeadFraction = maxDeadFraction;
+  }
+  // Both sides get nodes that live in the blocks of this tree
+  vector<shared_ptr<BinaryNode<ItemType>>> shared = move(blocks);
+  blocks.clear();
+  lower.blocks = shared;
+  upper.blocks = shared;
+
+  splitNodes(node, key, lower.rootPtr, upper.rootPtr);
+
+  // Count the smaller side and its tombstones by walking both sides in
+  // step
+  BinaryNode<ItemType> *lowerNode = getLeftMost(lower.rootPtr);
+  BinaryNode<ItemType> *upperNode = getLeftMost(upper.rootPtr);
+  int steps = 0;
+  int lowerDead = 0;
+  int upperDead = 0;
+  while (lowerNode != nullptr && upperNode != nullptr) {
+    lowerDead += lowerNode->getCount() == 0;
+    upperDead += upperNode->getCount() == 0;
+    lowerNode = inorderSucc(lowerNode);
+    upperNode = inorderSucc(upperNode);
+    steps++;
+  }
+  if (lowerNode == nullptr) {
+    lower.count = steps;
+    lower.dead = lowerDead;
+  } else {
+    lower.count = total - steps;
+    lower.dead = totalDead - upperDead;
+  }
+  upper.count = total - lower.count;
+  upper.dead = totalDead - lower.dead;
+
+  // The larger side keeps the filters of the tree, which hold its keys,
+  // the smaller side rebuilds its own from the nodes it was counted on
+  const bool lowerSmaller = lowerNode == nullptr;
+  ThreadedBST<ItemType> &larger = lowerSmaller ? upper : lower;
+  ThreadedBST<ItemType> &smaller = lowerSmaller ? lower : upper;
+  if (!larger.takeFilter(*this, smaller.count - smaller.dead)) {
+    larger.rebuildFilter();
+  }
+  smaller.rebuildFilter();
+  if (this != &lower && this != &upper) {
+    rebuildFilter();
+  }
+}
+
+/**
+ * @brief Joins two trees into this tree
+ *
+ * @pre every node of left <= every node of right, tree is empty or is
+ *      left or right itself
+ * @post tree holds the nodes of both, left and right are empty
+ * @param left tree with smaller nodes
+ * @param right tree with larger nodes
+ */
+template <typename ItemType>
+void ThreadedBST<ItemType>::join(ThreadedBST<ItemType> &left,
+                                 ThreadedBST<ItemType> &right) {
+  // Joining into a tree that holds other nodes would have to drop them
+  assert(rootPtr == nullptr || this == &left || this == &right);
+  abandonCompaction();
+  left.abandonCompaction();
+  right.abandonCompaction();
+  BinaryNode<ItemType> *lower = left.rootPtr;
+  BinaryNode<ItemType> *upper = right.rootPtr;
+  // The side with more nodes hands over its filters
+  const bool leftLarger = left.count >= right.count;
+  ThreadedBST<ItemType> &larger = leftLarger ? left : right;
+  BinaryNode<ItemType> *added = getLeftMost(leftLarger ? upper : lower);
+  const int addedNodes = leftLarger ? right.count : left.count;
+  int total = left.count + right.count;
+  int totalDead = left.dead + right.dead;
+  int joinedHeight = max(left.height, right.height) + 1;
+  left.rootPtr = nullptr;
+  left.count = 0;
+  left.dead = 0;
+  left.height = 0;
+  right.rootPtr = nullptr;
+  right.count = 0;
+  right.dead = 0;
+  right.height = 0;
+  // Empty by now unless the precondition was broken, then at least the
+  // nodes do not leak
+  clear(rootPtr);
+  vector<shared_ptr<BinaryNode<ItemType>>> joined = move(left.blocks);
+  if (&right != &left) {
+    joined.insert(joined.end(), right.blocks.begin(), right.blocks.end());
+  }
+  // Halves of one split share its blocks, hold each of them once
+  sort(joined.begin(), joined.end());
+  joined.erase(unique(joined.begin(), joined.end()), joined.end());
+  left.blocks.clear();
+  right.blocks.clear();
+  blocks = move(joined);
+
+  rootPtr = joinNodes(lower, upper);
+  count = total;
+  dead = totalDead;
+  height = (count == 0) ? 0 : joinedHeight;
+  // Only the keys of the smaller side are added to them
+  if (takeFilter(larger, 0)) {
+    for (int i = 0; i < addedNodes; i++) {
+      if (added->getCount() > 0) {
+        filterAdd(added->getItem());
+      }
+      added = inorderSucc(added);
+    }
+  } else {
+    rebuildFilter();
+  }
+  if (&left != this) {
+    left.rebuildFilter();
+  }
+  if (&right != this) {
+    right.rebuildFilter();
+  }
+}
+
+/**
+ * @brief Adds the keys of other that are not in tree
+ *
+ * @pre none
+ * @post tree holds the union of both key sets, a counted key keeps
+ *       the larger count
+ * @param other tree to merge from
+ */
+template <typename ItemType>
+void ThreadedBST<ItemType>::unionWith(const ThreadedBST<ItemType> &other) {
+  if (&other == this) {
+    return;
+  }
+  int added = 0;
+  // Tombstones of other count as missing, own ones are dropped first.
+  // Without any, the nodes stay where they are.
+  abandonCompaction();
+  if (lazy && dead > 0) {
+    purgeTombstones();
+  }
+  // New keys go into the filters as they are added if all keys of other
+  // fit, otherwise the filters are rebuilt once the tree is whole again
+  const bool wasFiltered = filtered;
+  const bool refilter =
+      filtered &&
+      filterKeys + (size_t)(other.count - other.dead) > filterCapacity;
+  if (refilter) {
+    filtered = false;
+  }
+  rootPtr = combineNodes(rootPtr, other.rootPtr, SET_UNION, added);
+  filtered = wasFiltered;
+  count += added;
+  // Every level of other adds at most one join level
+  height += other.height;
+  if (refilter) {
+    rebuildFilter();
+  }
+}
+
+/**
+ * @brief Removes the keys that are not in other
+ *
+ * @pre none
+ * @post tree holds the intersection of both key sets, a counted key
+ *       keeps the smaller count
+ * @param other tree to intersect with
+ */
+template <typename ItemType>
+void ThreadedBST<ItemType>::intersectWith(const ThreadedBST<ItemType> &other) {
+  if (&other == this) {
+    return;
+  }
+  int kept = 0;
+  abandonCompaction();
+  if (lazy && dead > 0) {
+    purgeTombstones();
+  }
+  rootPtr = combineNodes(rootPtr, other.rootPtr, SET_INTERSECTION, kept);
+  const int removed = count - kept;
+  count = kept;
+  filterRemove(removed);
+  height = (count == 0) ? 0 : height + other.height;
+}
+
+/**
+ * @brief Removes the keys that are in other
+ *
+ * @pre none
+ * @post tree holds the keys not found in other, counted copies are
+ *       subtracted
+ * @param other tree whose keys are removed
+ */
+template <typename ItemType>
+void ThreadedBST<ItemType>::differenceWith(const ThreadedBST<ItemType> &other) {
+  abandonCompaction();
+  if (&other == this) {
+    clear(rootPtr);
+    blocks.clear();
+    rootPtr = nullptr;
+    count = 0;
+    dead = 0;
+    height = 0;
+    rebuildFilter();
+    return;
+  }
+  int removed = 0;
+  if (lazy && dead > 0) {
+    purgeTombstones();
+  }
+  rootPtr = combineNodes(rootPtr, other.rootPtr, SET_DIFFERENCE, removed);
+  count -= removed;
+  filterRemove(removed);
+  height = (count == 0) ? 0 : height + other.height;
 }
 
 /**
@@ -509,15 +2673,147 @@ template <typename ItemType> void ThreadedBST<ItemType>::removeEven() {
  *
  * @pre none
  * @post inorder output of tree
+ * @param output stream to write to
  */
-template <typename ItemType> void ThreadedBST<ItemType>::inorderTraverse() {
+template <typename ItemType>
+void ThreadedBST<ItemType>::inorderTraverse(ostream &output) const {
   // start from the leftmost node
   BinaryNode<ItemType> *node = getLeftMost(rootPtr);
   while (node) {
-    // print the current node
-    cout << node->getItem() << " ";
+    // print every copy of the current node, none for a tombstone
+    for (int copy = 0; copy < node->getCount(); copy++) {
+      output << node->getItem() << " ";
+    }
 
     // go to the inorder successor
     node = inorderSucc(node);
   }
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Copies keys in order from a position into a buffer
+ *
+ * @pre out has room for capacity keys
+ * @post up to capacity keys less than high are written, from is moved
+ *       past them
+ * @param from position of the first key to copy
+ * @param high copying stops at the first key not less than it, nullptr
+ *        for no bound
+ * @param out buffer to write to
+ * @param capacity room in out
+ * @return size_t number of keys written
+ */
+template <typename ItemType>
+size_t ThreadedBST<ItemType>::copyKeys(iterator &from, const ItemType *high,
+                                       ItemType *out, size_t capacity) const {
+  BinaryNode<ItemType> *node = from.getNode();
+  int copy = from.getCopy();
+  size_t written = 0;
+  while (node != nullptr && written < capacity) {
+    // A right pointer is the successor or the subtree it starts, so load
+    // it while this node is written out
+    BinaryNode<ItemType> *next = node->getRightChildPtr();
+#if defined(__GNUC__)
+    __builtin_prefetch(next);
+#endif
+    if (high != nullptr && !(node->getItem() < *high)) {
+      break;
+    }
+    // Tombstones have no copies to write
+    const size_t take =
+        min((size_t)(node->getCount() - copy), capacity - written);
+    for (size_t i = 0; i < take; i++) {
+      out[written + i] = node->getItem();
+    }
+    written += take;
+    copy += (int)take;
+    if (copy < node->getCount()) {
+      break;
+    }
+    copy = 0;
+    if (!node->getRightThread() && next != nullptr) {
+      next = getLeftMost(next);
+    }
+    node = next;
+  }
+  // Leave from on a key that is still to be copied
+  while (node != nullptr && node->getCount() == 0) {
+    node = inorderSucc(node);
+  }
+  from = iterator(this, node, copy);
+  return written;
+}
+
+/**
+ * @brief Get every key in order
+ *
+ * @pre none
+ * @post returns sorted keys, a counted key once per copy
+ * @return vector<ItemType> keys of the tree
+ */
+template <typename ItemType>
+vector<ItemType> ThreadedBST<ItemType>::toVector() const {
+  // Every live node holds at least one key, so one pass fills the vector
+  // unless some nodes count duplicates
+  vector<ItemType> keys(count - dead);
+  iterator from = begin();
+  size_t size = copyKeys(from, nullptr, keys.data(), keys.size());
+  while (from != end()) {
+    keys.resize(2 * keys.size());
+    size += copyKeys(from, nullptr, keys.data() + size, keys.size() - size);
+  }
+  keys.resize(size);
+  return keys;
+}
+
+/**
+ * @brief Copies the smallest keys in order into a buffer
+ *
+ * @pre out has room for capacity keys
+ * @post up to capacity keys are written
+ * @param out buffer to write to
+ * @param capacity room in out
+ * @return size_t number of keys written
+ */
+template <typename ItemType>
+size_t ThreadedBST<ItemType>::copyTo(ItemType *out, size_t capacity) const {
+  iterator from = begin();
+  return copyKeys(from, nullptr, out, capacity);
+}
+
+/**
+ * @brief Copies the keys of a range in order into a buffer
+ *
+ * @pre out has room for capacity keys
+ * @post up to capacity keys k with low <= k < high are written
+ * @param low smallest key of the range
+ * @param high key just past the range
+ * @param out buffer to write to
+ * @param capacity room in out
+ * @return size_t number of keys written
+ */
+template <typename ItemType>
+size_t ThreadedBST<ItemType>::copyRangeTo(const ItemType &low,
+                                          const ItemType &high, ItemType *out,
+                                          size_t capacity) const {
+  iterator from(this, lowerBound(low));
+  return copyKeys(from, &high, out, capacity);
+}
+
+/**
+ * @brief Copies the next chunk of keys into a buffer
+ *
+ * @pre from is a position in this tree or end(), out has room for
+ *      capacity keys
+ * @post up to capacity keys are written and from is moved past them,
+ *       so calling again with the same iterator continues the export
+ * @param from position of the first key to copy
+ * @param out buffer to write to
+ * @param capacity room in out
+ * @return size_t number of keys written, 0 once from is at end()
+ */
+template <typename ItemType>
+size_t ThreadedBST<ItemType>::copyChunk(iterator &from, ItemType *out,
+                                        size_t capacity) const {
+  return copyKeys(from, nullptr, out, capacity);
+}
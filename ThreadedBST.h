@@ -2,6 +2,29 @@
  * @file ThreadedBST.h
  * @brief ThreadedBST header that declares ThreadedBST class.
  *        Implementation of a threaded BST.
+ *        By default every add makes a node, so equal keys become separate
+ *        nodes. A tree made with DUPLICATE_COUNTS is a multiset that keeps
+ *        one node per key and counts its copies instead.
+ *        In a splay access mode, contains and find on a non-const tree
+ *        rotate the node they reach toward the root, so hot keys are found
+ *        in a few steps. Lookups through a const tree never restructure.
+ *        With lazy deletion on, removing the last copy of a key leaves its
+ *        node linked as a tombstone with a count of 0. Lookups and
+ *        iterators skip tombstones, and once too many pile up compact()
+ *        drops them all while rebuilding the tree.
+ *        With the filter on, a blocked Bloom filter of the keys answers
+ *        most lookups of missing keys without touching a node. Only changes
+ *        write it: add updates it and rebuilds it once it is full, and the
+ *        removal that leaves too many removed keys in it rebuilds it, so
+ *        lookups only read it. Integer keys can
+ *        also get a range filter of key prefixes, so containsRange skips
+ *        the tree for most empty ranges.
+ *        toVector, copyTo, copyRangeTo and copyChunk export keys in order
+ *        straight into a buffer, copyChunk a fixed size piece at a time.
+ *        floor, ceiling, nearest and kNearest descend once to where the
+ *        key would go and then walk outward along the predecessor and
+ *        successor threads, so k neighbours cost O(log n + k) steps and
+ *        no allocation.
  * @author William Susanto and Robel Messele
  */
 
@@ -9,13 +32,30 @@
 #define THREADEDBST_
 
 #include "BinaryNode.h"
+#include "BloomFilter.h"
+#include "ThreadedBSTIterator.h"
+#include "TreeShape.h"
+#include "TreeStats.h"
+#include <algorithm>
+#include <cassert>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
 #include <iostream>
 #include <memory>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 using namespace std;
 
 template <typename ItemType> class ThreadedBST {
+  // Steps back from end() to the largest live node
+  friend class ThreadedBSTIterator<ItemType>;
+
   /**
    * @brief Outputs tree using inorder traversal
    *
@@ -26,16 +66,475 @@ template <typename ItemType> class ThreadedBST {
    * @return ostream& output
    */
   friend ostream &operator<<(ostream &output,
-                             ThreadedBST<ItemType> &ThreadedBST) {
-    ThreadedBST.inorderTraverse();
+                             const ThreadedBST<ItemType> &ThreadedBST) {
+    ThreadedBST.inorderTraverse(output);
     return output;
   }
 
 private:
   BinaryNode<ItemType> *rootPtr;
   int count = 0;
+  mutable int height = 0; // Upper bound on levels, exact after stats()
+  bool multiset = false;  // Count duplicates in one node
+  int access = 0;         // AccessMode of lookups
+  int splayMinDepth = 1;  // Shallower nodes are not splayed
+  vector<BinaryNode<ItemType> *> accessPath; // Root to the last lookup
+  bool lazy = false;             // Leave removed nodes as tombstones
+  double maxDeadFraction = 0.25; // Tombstones per node that trigger compact
+  int dead = 0;                  // Tombstones, included in count
+  bool filtered = false;         // Bloom filter answers misses
+  int filterBitsPerKey = 10;     // Filter bits per key
+  int filterPrefixBits = 0;      // Low key bits a range entry drops, 0 if off
+  BloomFilter<ItemType> keyFilter;   // Keys of the tree
+  BloomFilter<uint64_t> rangeFilter; // Key prefixes of the tree
+  size_t filterCapacity = 0;         // Keys the filters fit, 0 if unbuilt
+  size_t filterKeys = 0;             // Keys added to the filters
+  size_t filterRemoved = 0;          // Keys removed since the last rebuild
+
+  // Contiguous blocks made by compact() that nodes of this tree may live
+  // in. Nodes in a block are only destroyed on their own, the block is
+  // freed once no tree that split or join handed it to holds it.
+  vector<shared_ptr<BinaryNode<ItemType>>> blocks;
+
+  struct CompactState {
+    bool running = false;                    // Copy started, not swapped in
+    BinaryNode<ItemType> *cursor = nullptr;  // Next old node to copy
+    vector<pair<ItemType, int>> keys;        // Live keys and counts copied
+    vector<pair<ItemType, int>> changes;     // Copies added or removed after
+                                             // keys were copied
+    shared_ptr<BinaryNode<ItemType>> block;  // New nodes in breadth first order
+    size_t index = 0;                        // Next slot to fill, from 1
+    size_t prev = 0;                         // Last slot filled
+    size_t filled = 0;                       // Slots filled so far
+    BinaryNode<ItemType> *retired = nullptr; // Old nodes still to delete
+    vector<shared_ptr<BinaryNode<ItemType>>> retiredBlocks; // Their blocks
+  };
+  CompactState compaction;
+
+  /**
+   * @brief Splits a threaded subtree around a key
+   *
+   * @pre node is a threaded subtree with no threads leaving it
+   * @post lower holds nodes less than key, upper holds the rest
+   * @param node subtree pointer
+   * @param key key to split around
+   * @param lower root of subtree with nodes less than key
+   * @param upper root of subtree with nodes not less than key
+   */
+  void splitNodes(BinaryNode<ItemType> *node, const ItemType &key,
+                  BinaryNode<ItemType> *&lower, BinaryNode<ItemType> *&upper);
+
+  /**
+   * @brief Joins two threaded subtrees under a middle node
+   *
+   * @pre lower < mid <= upper, mid is detached
+   * @post threaded subtree rooted at mid is returned
+   * @param lower subtree with smaller nodes
+   * @param mid node to become the root
+   * @param upper subtree with larger nodes
+   * @return BinaryNode<ItemType>* root of joined subtree
+   */
+  BinaryNode<ItemType> *joinNodes(BinaryNode<ItemType> *lower,
+                                  BinaryNode<ItemType> *mid,
+                                  BinaryNode<ItemType> *upper);
+
+  /**
+   * @brief Joins two threaded subtrees
+   *
+   * @pre every node of lower <= every node of upper
+   * @post threaded subtree holding both is returned
+   * @param lower subtree with smaller nodes
+   * @param upper subtree with larger nodes
+   * @return BinaryNode<ItemType>* root of joined subtree
+   */
+  BinaryNode<ItemType> *joinNodes(BinaryNode<ItemType> *lower,
+                                  BinaryNode<ItemType> *upper);
+
+  /**
+   * @brief Detaches the leftmost node of a threaded subtree
+   *
+   * @pre node is not empty
+   * @post leftmost node is unlinked and node is updated to the new root
+   * @param node subtree pointer
+   * @return BinaryNode<ItemType>* detached node
+   */
+  BinaryNode<ItemType> *detachMin(BinaryNode<ItemType> *&node);
+
+  // Set operation combineNodes applies
+  enum SetOperation { SET_UNION, SET_INTERSECTION, SET_DIFFERENCE };
+
+  /**
+   * @brief Union, intersection or difference of a subtree with a read-only
+   *        subtree
+   *
+   * @pre node is a threaded subtree with no threads leaving it
+   * @post subtree holding the result is returned, nodes that drop out are
+   *       deleted
+   * @param node subtree to change
+   * @param other subtree whose keys are combined with node
+   * @param operation set operation to apply
+   * @param changed incremented for every node added, kept or deleted as
+   *        union, intersection or difference counts them
+   * @return BinaryNode<ItemType>* root of the resulting subtree
+   */
+  BinaryNode<ItemType> *combineNodes(BinaryNode<ItemType> *node,
+                                     BinaryNode<ItemType> *other,
+                                     SetOperation operation, int &changed);
+
+  /**
+   * @brief Adds a new node as the left child of a threaded node
+   *
+   * @pre parent has no left child
+   * @post new node is the left child of parent with threads set
+   * @param parent node to attach to
+   * @param data data of new node
+   * @return BinaryNode<ItemType>* pointer to new node
+   */
+  BinaryNode<ItemType> *attachLeft(BinaryNode<ItemType> *parent,
+                                   const ItemType &data);
+
+  /**
+   * @brief Adds a new node as the right child of a threaded node
+   *
+   * @pre parent has no right child
+   * @post new node is the right child of parent with threads set
+   * @param parent node to attach to
+   * @param data data of new node
+   * @return BinaryNode<ItemType>* pointer to new node
+   */
+  BinaryNode<ItemType> *attachRight(BinaryNode<ItemType> *parent,
+                                    const ItemType &data);
+
+  /**
+   * @brief Find a node and its parent
+   *
+   * @pre none
+   * @post returns node with given data or nullptr, parent is set
+   * @param node tree pointer to search from
+   * @param data data to look for
+   * @param parent parent of the returned node
+   * @return BinaryNode<ItemType>* node with given data
+   */
+  BinaryNode<ItemType> *findNode(BinaryNode<ItemType> *node,
+                                 const ItemType &data,
+                                 BinaryNode<ItemType> *&parent) const;
+
+  /**
+   * @brief Removes a node that has been found
+   *
+   * @pre ptr is in tree and parent is its parent
+   * @post removes node and returns inorder successor
+   * @param parent parent of removed node
+   * @param ptr pointer for removed node
+   * @return BinaryNode<ItemType>* inorder successor of removed node
+   */
+  BinaryNode<ItemType> *removeFound(BinaryNode<ItemType> *parent,
+                                    BinaryNode<ItemType> *ptr);
+
+  /**
+   * @brief Get the parent of a node from the threads around it
+   *
+   * @pre node is in tree
+   * @post returns parent of node, nullptr for the root
+   * @param node node to find the parent of
+   * @return BinaryNode<ItemType>* parent of node
+   */
+  BinaryNode<ItemType> *parentOf(BinaryNode<ItemType> *node) const;
+
+  /**
+   * @brief Searches a group of keys in lockstep
+   *
+   * @pre size <= BATCH_LANES
+   * @post found holds the node of each key or nullptr
+   * @param keys keys to look for
+   * @param size number of keys
+   * @param found node found for each key
+   */
+  void findGroup(const ItemType *keys, size_t size,
+                 BinaryNode<ItemType> **found) const;
+
+  /**
+   * @brief Copies keys in order from a position into a buffer
+   *
+   * @pre out has room for capacity keys
+   * @post up to capacity keys less than high are written, from is moved
+   *       past them
+   * @param from position of the first key to copy
+   * @param high copying stops at the first key not less than it, nullptr
+   *        for no bound
+   * @param out buffer to write to
+   * @param capacity room in out
+   * @return size_t number of keys written
+   */
+  size_t copyKeys(ThreadedBSTIterator<ItemType> &from, const ItemType *high,
+                  ItemType *out, size_t capacity) const;
+
+  /**
+   * @brief Deallocate a node from the heap or from a compacted block
+   *
+   * @pre node is detached
+   * @post node is destroyed and its memory freed or its slot released
+   * @param node node to delete
+   */
+  static void deleteNode(BinaryNode<ItemType> *node);
+
+  /**
+   * @brief Empty part of a tree within a work budget
+   *
+   * @pre none
+   * @post up to budget steps of clear are done, budget is decreased
+   * @param node tree pointer
+   * @param budget steps left
+   * @return BinaryNode<ItemType>* where to resume, nullptr when done
+   */
+  BinaryNode<ItemType> *clearSome(BinaryNode<ItemType> *node, size_t &budget);
+
+  /**
+   * @brief Get the next slot of a breadth first layout in inorder
+   *
+   * @pre 1 <= index <= size
+   * @post returns inorder successor slot
+   * @param index slot, counting from 1
+   * @param size number of slots
+   * @return size_t successor slot, 0 after the last
+   */
+  static size_t breadthNext(size_t index, size_t size);
+
+  /**
+   * @brief Drop a compaction that has not been swapped in yet
+   *
+   * @pre none
+   * @post copied keys and nodes are dropped, their block released
+   */
+  void abandonCompaction();
+
+  /**
+   * @brief Checks if a running compaction has copied a node already
+   *
+   * @pre compaction is running, node is in tree
+   * @post returns if node comes before the copy cursor in inorder
+   * @param node node to check
+   * @return bool true if the copy will not read node again
+   */
+  bool copiedAlready(BinaryNode<ItemType> *node) const;
+
+  /**
+   * @brief Tell a running compaction that copies of a node changed
+   *
+   * @pre node is in tree, called before a removal changes it
+   * @post change is kept for the compacted tree if its copy missed it
+   * @param node node that gained or lost copies
+   * @param copies copies added, negative if removed
+   */
+  void noteChange(BinaryNode<ItemType> *node, int copies);
+
+  /**
+   * @brief Add or remove copies of a key without a lookup filter update
+   *
+   * @pre removed copies are in tree
+   * @post tree holds copies more of data, fewer if negative
+   * @param data key to change
+   * @param copies copies to add, negative to remove
+   */
+  void applyChange(const ItemType &data, int copies);
+
+  /**
+   * @brief Delete the nodes the last compaction replaced within a budget
+   *
+   * @pre none
+   * @post up to budget old nodes are deleted, their blocks released once
+   *       all are gone
+   * @param budget steps left
+   * @return bool true once no old node is left
+   */
+  bool retireSome(size_t &budget);
+
+  /**
+   * @brief Rotates a node above its parent
+   *
+   * @pre child is a child of parent, parent is a child of grand or the
+   *      root when grand is nullptr
+   * @post child takes the place of parent, threads are kept
+   * @param child node to move up
+   * @param parent node to move down
+   * @param grand parent of parent or nullptr
+   */
+  void rotateUp(BinaryNode<ItemType> *child, BinaryNode<ItemType> *parent,
+                BinaryNode<ItemType> *grand);
+
+  /**
+   * @brief Splays the last node of accessPath
+   *
+   * @pre accessPath holds the nodes from the root down to the node
+   * @post node is moved up as the access mode says
+   */
+  void splayPath();
+
+  /**
+   * @brief Search that splays the node it reaches
+   *
+   * @pre none
+   * @post node with data or the last node visited is splayed
+   * @param data data to look for
+   * @return BinaryNode<ItemType>* node with data or nullptr
+   */
+  BinaryNode<ItemType> *accessNode(const ItemType &data);
+
+  /**
+   * @brief Find a node with given data that is not a tombstone
+   *
+   * @pre none
+   * @post returns first live node with data in inorder or nullptr
+   * @param data data to look for
+   * @return BinaryNode<ItemType>* live node with data
+   */
+  BinaryNode<ItemType> *liveNode(const ItemType &data) const;
+
+  /**
+   * @brief Takes copies from a node, leaving a tombstone when none are left
+   *
+   * @pre node is live and in tree, copies <= its count
+   * @post node has copies fewer, a tombstone once none are left
+   * @param node node to take a copy from
+   * @param copies copies to take
+   */
+  void killCopies(BinaryNode<ItemType> *node, int copies);
+
+  /**
+   * @brief Compact if tombstones passed their limit
+   *
+   * @pre none
+   * @post tombstones are at most maxDeadFraction of the nodes
+   */
+  void checkTombstones();
+
+  /**
+   * @brief Compact until no tombstones are left
+   *
+   * @pre none
+   * @post tree has no tombstones
+   */
+  void purgeTombstones();
+
+  /**
+   * @brief Get the live node before a position
+   *
+   * @pre node is in tree or nullptr
+   * @post returns largest live node less than node, the largest live
+   *       node if node is nullptr, nullptr if none
+   * @param node position, nullptr for past the largest node
+   * @return BinaryNode<ItemType>* live predecessor
+   */
+  BinaryNode<ItemType> *livePred(BinaryNode<ItemType> *node) const;
+
+  /**
+   * @brief Get the live node after a node
+   *
+   * @pre node is in tree
+   * @post returns smallest live node greater than node or nullptr
+   * @param node position
+   * @return BinaryNode<ItemType>* live successor
+   */
+  BinaryNode<ItemType> *liveSucc(BinaryNode<ItemType> *node) const;
+
+  /**
+   * @brief Rebuild the filters from the live keys of the tree
+   *
+   * @pre none
+   * @post filters hold every live key of the tree if they are on
+   */
+  void rebuildFilter();
+
+  /**
+   * @brief Add a key to the filters
+   *
+   * @pre none
+   * @post key is in the filters if they are on, rebuilt first if full
+   * @param data key to add
+   */
+  void filterAdd(const ItemType &data);
+
+  /**
+   * @brief Count keys removed from the tree against the filters
+   *
+   * @pre none
+   * @post filters are rebuilt once removed keys make up half of them
+   * @param removed keys removed
+   */
+  void filterRemove(size_t removed);
+
+  /**
+   * @brief Take over the filters of another tree
+   *
+   * @pre filters of from hold every live key of tree, tree is whole
+   * @post tree uses them with foreign keys counted as removed and from
+   *       needs a rebuild, unless filter settings differ or either is off
+   * @param from tree whose filters are taken, may be tree itself
+   * @param foreign keys in them that tree does not hold
+   * @return bool true if taken
+   */
+  bool takeFilter(ThreadedBST<ItemType> &from, size_t foreign);
+
+  /**
+   * @brief Checks if the filter rules a key out
+   *
+   * @pre none
+   * @post returns true only if data is not in tree
+   * @param data data to look for
+   * @return bool true if data is surely missing
+   */
+  bool filteredOut(const ItemType &data) const;
+
+  /**
+   * @brief Get range filter entry of an integer key
+   *
+   * @pre ItemType is an integer type
+   * @post return key prefix, in the same order as keys
+   * @param data key to map
+   * @return uint64_t key prefix
+   */
+  uint64_t prefixOf(const ItemType &data) const;
 
 public:
+  typedef ThreadedBSTIterator<ItemType> iterator;
+
+  // How add treats a key that is already in the tree
+  enum DuplicateMode { DUPLICATE_NODES, DUPLICATE_COUNTS };
+
+  // How lookups on a non-const tree change its shape. ACCESS_SPLAY moves
+  // the node to the root. ACCESS_SEMI_SPLAY only lifts the parent in the
+  // zig-zig step, which about halves the depth of the path with fewer
+  // rotations.
+  enum AccessMode { ACCESS_STATIC, ACCESS_SPLAY, ACCESS_SEMI_SPLAY };
+
+  // Number of searches findBatch and containsBatch keep in flight
+  static constexpr size_t BATCH_LANES = 16;
+
+  // Ranges spanning more key prefixes than this skip the range filter
+  static constexpr uint64_t MAX_RANGE_PROBES = 16;
+
+  // Default distance of nearest and kNearest, |a - b| for number keys
+  struct KeyDistance {
+    // Integer keys measure in their unsigned type, which holds the
+    // distance between any two of them
+    typedef typename conditional<is_integral<ItemType>::value &&
+                                     !is_same<ItemType, bool>::value,
+                                 make_unsigned<ItemType>,
+                                 enable_if<true, ItemType>>::type::type
+        result_type;
+
+    /**
+     * @brief Get distance between keys
+     *
+     * @pre ItemType supports subtraction
+     * @post return absolute difference, without overflow for integer keys
+     * @param a first key
+     * @param b second key
+     * @return result_type distance
+     */
+    result_type operator()(const ItemType &a, const ItemType &b) const;
+  };
+
   /**
    * @brief Default constructor
    *
@@ -54,7 +553,16 @@ public:
   ThreadedBST(const int &n);
 
   /**
-   * @brief Recursively halves and adds midpoint from m to n
+   * @brief Duplicate mode constructor
+   *
+   * @pre none
+   * @post empty ThreadedBST that stores duplicates as given
+   * @param mode DUPLICATE_COUNTS to count copies in one node
+   */
+  explicit ThreadedBST(DuplicateMode mode);
+
+  /**
+   * @brief Adds m to n in midpoint order so the result stays balanced
    *
    * @pre Existing ThreadedBST
    * @post ThreadedBST with nodes from m to n
@@ -84,45 +592,318 @@ public:
    * @brief Get depth
    *
    * @pre none
-   * @post return tree depth
+   * @post return tree depth, tracked on every change so it is exact while
+   *       only adding and an upper bound after removals or splaying until
+   *       stats()
    * @return int depth
    */
   int getDepth() const;
 
+  /**
+   * @brief Measure the shape of the tree
+   *
+   * @pre none
+   * @post returns structural statistics, getDepth() is exact afterwards
+   * @return TreeShape height, path lengths, depth histogram, link counts,
+   *         memory estimate and locality of the tree
+   */
+  TreeShape stats() const;
+
+  /**
+   * @brief Get duplicate mode
+   *
+   * @pre none
+   * @post return how duplicates are stored
+   * @return DuplicateMode duplicate mode
+   */
+  DuplicateMode getDuplicateMode() const;
+
+  /**
+   * @brief Set how lookups change the shape of the tree
+   *
+   * @pre minDepth >= 1
+   * @post later lookups on a non-const tree follow mode
+   * @param mode access mode
+   * @param minDepth nodes found above this depth are left in place
+   */
+  void setAccessMode(AccessMode mode, int minDepth = 1);
+
+  /**
+   * @brief Get access mode
+   *
+   * @pre none
+   * @post return how lookups change the shape of the tree
+   * @return AccessMode access mode
+   */
+  AccessMode getAccessMode() const;
+
+  /**
+   * @brief Turn lazy deletion on or off
+   *
+   * @pre 0 <= maxDead < 1
+   * @post removals leave tombstones while enabled, compacting once they
+   *       pass maxDead of the nodes. Turning it off drops tombstones now.
+   * @param enabled true to leave tombstones
+   * @param maxDead fraction of nodes that may be tombstones
+   */
+  void setLazyDelete(bool enabled, double maxDead = 0.25);
+
+  /**
+   * @brief Get if lazy deletion is on
+   *
+   * @pre none
+   * @post return if removals leave tombstones
+   * @return bool true if lazy
+   */
+  bool getLazyDelete() const;
+
+  /**
+   * @brief Turn the lookup filters on or off
+   *
+   * @pre bitsPerKey > 0, 0 <= prefixBits < 64
+   * @post lookups of missing keys mostly skip the tree while enabled.
+   *       With prefixBits > 0 and integer keys, keys that agree above
+   *       their prefixBits low bits share a range filter entry.
+   * @param enabled true to filter lookups
+   * @param bitsPerKey filter bits per key, 10 gives about 1% false
+   *        positives
+   * @param prefixBits low key bits a range filter entry drops, 0 for no
+   *        range filter
+   */
+  void setFilter(bool enabled, int bitsPerKey = 10, int prefixBits = 0);
+
+  /**
+   * @brief Get if the lookup filters are on
+   *
+   * @pre none
+   * @post return if lookups are filtered
+   * @return bool true if filtered
+   */
+  bool getFilter() const;
+
   /**
    * @brief Adds new node to tree
    *
    * @pre none
-   * @post new node is added to tree and returned
-   * @param node tree pointer
+   * @post new node is added to tree with threads set and returned, when
+   *       counting duplicates an existing node for data is counted up
+   *       instead
+   * @param node tree pointer, nullptr for the root
    * @param data data of new node
-   * @return BinaryNode<ItemType>* pointer to new node
+   * @return BinaryNode<ItemType>* pointer to node holding data
    */
   BinaryNode<ItemType> *add(BinaryNode<ItemType> *node, const ItemType &data);
 
+  /**
+   * @brief Checks if a node with given data exists
+   *
+   * @pre none
+   * @post returns if data is in tree
+   * @param data data to look for
+   * @return bool true if found
+   */
+  bool contains(const ItemType &data) const;
+
+  /**
+   * @brief Checks if a node with given data exists, splaying it
+   *
+   * @pre none
+   * @post returns if data is in tree, the node reached is splayed as the
+   *       access mode says
+   * @param data data to look for
+   * @return bool true if found
+   */
+  bool contains(const ItemType &data);
+
+  /**
+   * @brief Get number of copies of given data
+   *
+   * @pre none
+   * @post returns copies of data in tree
+   * @param data data to look for
+   * @return int number of copies
+   */
+  int countOf(const ItemType &data) const;
+
+  /**
+   * @brief Get the first node not less than given data
+   *
+   * @pre none
+   * @post returns lower bound node or nullptr
+   * @param data data to look for
+   * @return BinaryNode<ItemType>* first node not less than data
+   */
+  BinaryNode<ItemType> *lowerBound(const ItemType &data) const;
+
+  /**
+   * @brief Get the largest node not greater than given data
+   *
+   * @pre none
+   * @post returns floor node or nullptr
+   * @param data data to look for
+   * @return BinaryNode<ItemType>* last node not greater than data
+   */
+  BinaryNode<ItemType> *floor(const ItemType &data) const;
+
+  /**
+   * @brief Get the smallest node not less than given data
+   *
+   * @pre none
+   * @post returns ceiling node or nullptr
+   * @param data data to look for
+   * @return BinaryNode<ItemType>* first node not less than data
+   */
+  BinaryNode<ItemType> *ceiling(const ItemType &data) const;
+
+  /**
+   * @brief Get the node closest to given data
+   *
+   * @pre distance(a, b) is symmetric and grows away from a in both
+   *      directions
+   * @post returns closest node, the smaller one on a tie, nullptr if tree
+   *       is empty
+   * @param data data to look for
+   * @param distance functor giving the distance between two keys
+   * @return BinaryNode<ItemType>* nearest node
+   */
+  template <class Distance = KeyDistance>
+  BinaryNode<ItemType> *nearest(const ItemType &data,
+                                Distance distance = Distance()) const;
+
+  /**
+   * @brief Get the keys closest to given data
+   *
+   * @pre out has room for k keys, distance is as for nearest
+   * @post up to k keys are written nearest first, the smaller key first on
+   *       a tie, a counted key once per copy
+   * @param data data to look for
+   * @param k number of keys wanted
+   * @param out buffer to write to
+   * @param distance functor giving the distance between two keys
+   * @return size_t number of keys written, less than k only if the tree
+   *         holds fewer
+   */
+  template <class Distance = KeyDistance>
+  size_t kNearest(const ItemType &data, size_t k, ItemType *out,
+                  Distance distance = Distance()) const;
+
+  /**
+   * @brief Checks if any key lies in a range
+   *
+   * @pre none
+   * @post returns if some key k has low <= k < high
+   * @param low smallest key of the range
+   * @param high key just past the range
+   * @return bool true if the range holds a key
+   */
+  bool containsRange(const ItemType &low, const ItemType &high) const;
+
   /**
    * @brief Removes node with given data if exists
    *
    * @pre none
-   * @post removes node if exists and returns inorder successor
-   * @param node tree pointer
+   * @post removes one copy of data if exists and returns inorder
+   *       successor of its node
+   * @param node tree pointer, nullptr for the root
    * @param data data of node to remove
-   * @return BinaryNode<ItemType>* inorder successor of removed node
+   * @return BinaryNode<ItemType>* inorder successor of removed node, nullptr
+   *         if data is not in tree or the largest node was removed
    */
-  BinaryNode<ItemType> *removeNode(BinaryNode<ItemType> *node, int data);
+  BinaryNode<ItemType> *removeNode(BinaryNode<ItemType> *node,
+                                   const ItemType &data);
+
+  /**
+   * @brief Removes every node with given data
+   *
+   * @pre none
+   * @post no copy of given data is left in tree
+   * @param data data of nodes to remove
+   * @return int number of removed copies
+   */
+  int erase(const ItemType &data);
+
+  /**
+   * @brief Removes one copy of given data and returns its item
+   *
+   * @pre none
+   * @post copy is removed if exists
+   * @param data data of node to remove
+   * @return optional<ItemType> removed item, empty if data is not in tree
+   */
+  optional<ItemType> extract(const ItemType &data);
+
+  /**
+   * @brief Find a node with given data
+   *
+   * @pre none
+   * @post returns iterator to node or end()
+   * @param data data to look for
+   * @return iterator position of data
+   */
+  iterator find(const ItemType &data) const;
+
+  /**
+   * @brief Find a node with given data, splaying it
+   *
+   * @pre none
+   * @post returns iterator to node or end(), the node reached is splayed
+   *       as the access mode says
+   * @param data data to look for
+   * @return iterator position of data
+   */
+  iterator find(const ItemType &data);
+
+  /**
+   * @brief Find many keys, overlapping the cache misses of their searches
+   *
+   * @pre results has room for size iterators
+   * @post results holds the position of each key or end()
+   * @param keys keys to look for
+   * @param size number of keys
+   * @param results position found for each key
+   */
+  void findBatch(const ItemType *keys, size_t size, iterator *results) const;
+
+  /**
+   * @brief Check many keys, overlapping the cache misses of their searches
+   *
+   * @pre results has room for size flags
+   * @post results holds if each key is in tree
+   * @param keys keys to look for
+   * @param size number of keys
+   * @param results true for each key found
+   */
+  void containsBatch(const ItemType *keys, size_t size, bool *results) const;
+
+  /**
+   * @brief Get iterator to the smallest node
+   *
+   * @pre none
+   * @post returns iterator to leftmost node
+   * @return iterator first position
+   */
+  iterator begin() const;
+
+  /**
+   * @brief Get iterator past the largest node
+   *
+   * @pre none
+   * @post returns end iterator
+   * @return iterator end position
+   */
+  iterator end() const;
 
   /**
    * @brief Remove a node with no children
    *
    * @pre a node with no children
    * @post removes node and returns inorder successor
-   * @param node tree pointer
    * @param parent parent of removed node
    * @param ptr pointer for removed node
-   * @return BinaryNode<int>* inorder successor of removed node
+   * @return BinaryNode<ItemType>* inorder successor of removed node
    */
-  BinaryNode<int> *caseA(BinaryNode<int> *node, BinaryNode<int> *parent,
-                         BinaryNode<int> *ptr);
+  BinaryNode<ItemType> *caseA(BinaryNode<ItemType> *parent,
+                              BinaryNode<ItemType> *ptr);
 
   /**
    * @brief Remove a node with one child
@@ -131,20 +912,20 @@ public:
    * @post removes node and returns inorder successor
    * @param parent parent of removed node
    * @param ptr pointer for removed node
-   * @return BinaryNode<int>* inorder successor of removed node
+   * @return BinaryNode<ItemType>* inorder successor of removed node
    */
-  BinaryNode<int> *caseB(BinaryNode<int> *parent, BinaryNode<int> *ptr);
+  BinaryNode<ItemType> *caseB(BinaryNode<ItemType> *parent,
+                              BinaryNode<ItemType> *ptr);
 
   /**
    * @brief Remove a node with two children
    *
    * @pre a node with two children
    * @post removes node and returns inorder successor
-   * @param node tree pointer
    * @param ptr pointer for removed node
-   * @return BinaryNode<int>* inorder successor of removed node
+   * @return BinaryNode<ItemType>* inorder successor of removed node
    */
-  BinaryNode<int> *caseC(BinaryNode<int> *node, BinaryNode<int> *ptr);
+  BinaryNode<ItemType> *caseC(BinaryNode<ItemType> *ptr);
 
   /**
    * @brief Returns inorder successor of node
@@ -152,9 +933,9 @@ public:
    * @pre none
    * @post returns inorder successor of node
    * @param ptr node to get inorder successor of
-   * @return BinaryNode<int>* inorder successor of node
+   * @return BinaryNode<ItemType>* inorder successor of node
    */
-  BinaryNode<int> *inorderSucc(BinaryNode<int> *ptr);
+  BinaryNode<ItemType> *inorderSucc(BinaryNode<ItemType> *ptr) const;
 
   /**
    * @brief Returns inorder predecessor of node
@@ -162,9 +943,9 @@ public:
    * @pre none
    * @post returns inorder predecessor of node
    * @param ptr node to get inorder predecessor of
-   * @return BinaryNode<int>* inorder predecessor of node
+   * @return BinaryNode<ItemType>* inorder predecessor of node
    */
-  BinaryNode<int> *inorderPred(BinaryNode<int> *ptr);
+  BinaryNode<ItemType> *inorderPred(BinaryNode<ItemType> *ptr) const;
 
   /**
    * @brief Empty tree and deallocate memory
@@ -204,6 +985,20 @@ public:
    */
   void setThread(BinaryNode<ItemType> *node);
 
+  /**
+   * @brief Rebalance tree and move it into one contiguous block
+   *
+   * @pre none
+   * @post live keys are copied in inorder and rebuilt as a complete
+   *       tree laid out breadth first, threads are rewired and the old
+   *       nodes deleted. Changes between slices to keys already copied
+   *       are replayed on the new tree, so adding and removing keeps
+   *       the copy going instead of restarting it.
+   * @param budget nodes to handle in this slice, 0 for no limit
+   * @return bool true once compaction is complete
+   */
+  bool compact(size_t budget = 0);
+
   /**
    * @brief Remove even nodes
    *
@@ -212,13 +1007,120 @@ public:
    */
   void removeEven();
 
+  /**
+   * @brief Splits tree into nodes less than key and the rest. Cutting
+   *        follows one search path and counting walks the smaller side,
+   *        so a split takes O(height + smaller side) steps The larger
+   *        side keeps the filters, unless its filter settings differ.
+   *
+   * @pre none
+   * @post tree is empty unless it is lower or upper, lower and upper are
+   *       threaded trees with its duplicate mode and lazy deletion
+   *       settings, their previous nodes are deleted
+   * @param key key to split around
+   * @param lower tree for nodes less than key
+   * @param upper tree for nodes not less than key
+   */
+  void split(const ItemType &key, ThreadedBST<ItemType> &lower,
+             ThreadedBST<ItemType> &upper);
+
+  /**
+   * @brief Joins two trees into this tree
+   *
+   * @pre every node of left <= every node of right, tree is empty or is
+   *      left or right itself
+   * @post tree holds the nodes of both, left and right are empty
+   * @param left tree with smaller nodes
+   * @param right tree with larger nodes
+   */
+  void join(ThreadedBST<ItemType> &left, ThreadedBST<ItemType> &right);
+
+  /**
+   * @brief Adds the keys of other that are not in tree
+   *
+   * @pre none
+   * @post tree holds the union of both key sets, a counted key keeps
+   *       the larger count
+   * @param other tree to merge from
+   */
+  void unionWith(const ThreadedBST<ItemType> &other);
+
+  /**
+   * @brief Removes the keys that are not in other
+   *
+   * @pre none
+   * @post tree holds the intersection of both key sets, a counted key
+   *       keeps the smaller count
+   * @param other tree to intersect with
+   */
+  void intersectWith(const ThreadedBST<ItemType> &other);
+
+  /**
+   * @brief Removes the keys that are in other
+   *
+   * @pre none
+   * @post tree holds the keys not found in other, counted copies are
+   *       subtracted
+   * @param other tree whose keys are removed
+   */
+  void differenceWith(const ThreadedBST<ItemType> &other);
+
   /**
    * @brief Outputs tree using inorder traversal
    *
    * @pre none
    * @post inorder output of tree
+   * @param output stream to write to
+   */
+  void inorderTraverse(ostream &output = cout) const;
+
+  /**
+   * @brief Get every key in order
+   *
+   * @pre none
+   * @post returns sorted keys, a counted key once per copy
+   * @return vector<ItemType> keys of the tree
+   */
+  vector<ItemType> toVector() const;
+
+  /**
+   * @brief Copies the smallest keys in order into a buffer
+   *
+   * @pre out has room for capacity keys
+   * @post up to capacity keys are written
+   * @param out buffer to write to
+   * @param capacity room in out
+   * @return size_t number of keys written
+   */
+  size_t copyTo(ItemType *out, size_t capacity) const;
+
+  /**
+   * @brief Copies the keys of a range in order into a buffer
+   *
+   * @pre out has room for capacity keys
+   * @post up to capacity keys k with low <= k < high are written
+   * @param low smallest key of the range
+   * @param high key just past the range
+   * @param out buffer to write to
+   * @param capacity room in out
+   * @return size_t number of keys written
+   */
+  size_t copyRangeTo(const ItemType &low, const ItemType &high, ItemType *out,
+                     size_t capacity) const;
+
+  /**
+   * @brief Copies the next chunk of keys into a buffer
+   *
+   * @pre from is a position in this tree or end(), out has room for
+   *      capacity keys
+   * @post up to capacity keys are written and from is moved past them,
+   *       so calling again with the same iterator continues the export
+   * @param from position of the first key to copy
+   * @param out buffer to write to
+   * @param capacity room in out
+   * @return size_t number of keys written, 0 once from is at end()
    */
-  void inorderTraverse();
+  size_t copyChunk(iterator &from, ItemType *out, size_t capacity) const;
 }; // end ThreadedBST
 
 #include "ThreadedBST.cpp"
@@ -0,0 +1,233 @@
+/**
+ * @file ThreadedBSTIterator.cpp
+ * @brief ThreadedBSTIterator header that declares ThreadedBSTIterator class
+ * @author William Susanto and Robel Messele
+ */
+#include "ThreadedBSTIterator.h"
+
+/**
+ * @brief Constructor
+ *
+ * @pre none
+ * @post end iterator of no tree, it cannot be decremented
+ */
+template <class ItemType> ThreadedBSTIterator<ItemType>::ThreadedBSTIterator() {
+  tree = nullptr;
+  current = nullptr;
+  copy = 0;
+}
+
+/**
+ * @brief Constructor
+ *
+ * @pre node is in owner or nullptr, copyIndex < its count
+ * @post iterator at copy copyIndex of node, end of owner if nullptr
+ * @param owner tree the node is in
+ * @param node node to start at
+ * @param copyIndex copy of the node item to start at
+ */
+template <class ItemType>
+ThreadedBSTIterator<ItemType>::ThreadedBSTIterator(
+    const ThreadedBST<ItemType> *owner, BinaryNode<ItemType> *node,
+    int copyIndex) {
+  tree = owner;
+  current = node;
+  copy = copyIndex;
+}
+
+/**
+ * @brief Get item at this position
+ *
+ * @pre not the end iterator
+ * @post return node item
+ * @return ItemType node item
+ */
+template <class ItemType>
+ItemType ThreadedBSTIterator<ItemType>::operator*() const {
+  return current->getItem();
+}
+
+/**
+ * @brief Get node at this position
+ *
+ * @pre none
+ * @post return node or nullptr at end
+ * @return BinaryNode<ItemType>* node
+ */
+template <class ItemType>
+BinaryNode<ItemType> *ThreadedBSTIterator<ItemType>::getNode() const {
+  return current;
+}
+
+/**
+ * @brief Get number of copies of the item at this position
+ *
+ * @pre not the end iterator
+ * @post return copies held by the node
+ * @return int number of copies
+ */
+template <class ItemType> int ThreadedBSTIterator<ItemType>::getCount() const {
+  return current->getCount();
+}
+
+/**
+ * @brief Get which copy of the item this position is at
+ *
+ * @pre none
+ * @post return copy index, 0 at end
+ * @return int copy index, from 0
+ */
+template <class ItemType> int ThreadedBSTIterator<ItemType>::getCopy() const {
+  return copy;
+}
+
+/**
+ * @brief Move to the next distinct key
+ *
+ * @pre not the end iterator
+ * @post iterator at first copy of the successor node or end
+ * @return ThreadedBSTIterator& this iterator
+ */
+template <class ItemType>
+ThreadedBSTIterator<ItemType> &ThreadedBSTIterator<ItemType>::nextKey() {
+  copy = current->getCount() - 1;
+  return ++(*this);
+}
+
+/**
+ * @brief Move to inorder successor
+ *
+ * @pre not the end iterator
+ * @post iterator at next copy, successor or end
+ * @return ThreadedBSTIterator& this iterator
+ */
+template <class ItemType>
+ThreadedBSTIterator<ItemType> &ThreadedBSTIterator<ItemType>::operator++() {
+  TBST_TIMER(SUCC);
+  // Stay on the node until every copy has been visited
+  if (++copy < current->getCount()) {
+    return *this;
+  }
+  copy = 0;
+  // Tombstones have no copies and are passed over
+  do {
+    // Thread leads straight to the successor
+    if (current->getRightThread()) {
+      TBST_STAT(THREAD_FOLLOWS);
+      current = current->getRightChildPtr();
+      continue;
+    }
+    // Otherwise the successor is the leftmost node of the right subtree
+    TBST_STAT(CHILD_FOLLOWS);
+    current = current->getRightChildPtr();
+    if (current != nullptr) {
+      while (current->getLeftChildPtr() != nullptr &&
+             !(current->getLeftThread())) {
+        current = current->getLeftChildPtr();
+      }
+    }
+  } while (current != nullptr && current->getCount() == 0);
+  return *this;
+}
+
+/**
+ * @brief Move to inorder successor
+ *
+ * @pre not the end iterator
+ * @post iterator at next copy, successor or end
+ * @return ThreadedBSTIterator iterator before moving
+ */
+template <class ItemType>
+ThreadedBSTIterator<ItemType> ThreadedBSTIterator<ItemType>::operator++(int) {
+  ThreadedBSTIterator<ItemType> before = *this;
+  ++(*this);
+  return before;
+}
+
+/**
+ * @brief Move to inorder predecessor
+ *
+ * @pre not the end iterator of no tree
+ * @post iterator at previous copy or last copy of predecessor, end if
+ *       at the smallest node, last copy of the largest key if at end
+ * @return ThreadedBSTIterator& this iterator
+ */
+template <class ItemType>
+ThreadedBSTIterator<ItemType> &ThreadedBSTIterator<ItemType>::operator--() {
+  TBST_TIMER(SUCC);
+  if (copy > 0) {
+    copy--;
+    return *this;
+  }
+  // Back from the end is the largest live node
+  if (current == nullptr) {
+    current = tree->livePred(nullptr);
+    copy = (current == nullptr) ? 0 : current->getCount() - 1;
+    return *this;
+  }
+  // Tombstones have no copies and are passed over
+  do {
+    // Thread leads straight to the predecessor
+    if (current->getLeftThread()) {
+      TBST_STAT(THREAD_FOLLOWS);
+      current = current->getLeftChildPtr();
+      continue;
+    }
+    // Otherwise the predecessor is the rightmost node of the left subtree
+    TBST_STAT(CHILD_FOLLOWS);
+    current = current->getLeftChildPtr();
+    if (current != nullptr) {
+      while (current->getRightChildPtr() != nullptr &&
+             !(current->getRightThread())) {
+        current = current->getRightChildPtr();
+      }
+    }
+  } while (current != nullptr && current->getCount() == 0);
+  if (current != nullptr) {
+    copy = current->getCount() - 1;
+  }
+  return *this;
+}
+
+/**
+ * @brief Move to inorder predecessor
+ *
+ * @pre not the end iterator of no tree
+ * @post iterator at previous copy or last copy of predecessor, end if
+ *       at the smallest node, last copy of the largest key if at end
+ * @return ThreadedBSTIterator iterator before moving
+ */
+template <class ItemType>
+ThreadedBSTIterator<ItemType> ThreadedBSTIterator<ItemType>::operator--(int) {
+  ThreadedBSTIterator<ItemType> before = *this;
+  --(*this);
+  return before;
+}
+
+/**
+ * @brief Compare positions
+ *
+ * @pre none
+ * @post return if both are at the same copy of the same node
+ * @param other iterator to compare with
+ * @return bool true if equal
+ */
+template <class ItemType>
+bool ThreadedBSTIterator<ItemType>::operator==(
+    const ThreadedBSTIterator<ItemType> &other) const {
+  return current == other.current && copy == other.copy;
+}
+
+/**
+ * @brief Compare positions
+ *
+ * @pre none
+ * @post return if iterators are at different nodes or copies
+ * @param other iterator to compare with
+ * @return bool true if not equal
+ */
+template <class ItemType>
+bool ThreadedBSTIterator<ItemType>::operator!=(
+    const ThreadedBSTIterator<ItemType> &other) const {
+  return current != other.current || copy != other.copy;
+}
@@ -0,0 +1,159 @@
+/**
+ * @file ThreadedBSTIterator.h
+ * @brief ThreadedBSTIterator header that declares ThreadedBSTIterator class.
+ *        An inorder iterator that follows the threads of a threaded BST.
+ *        A node counting duplicates is visited once per copy, nextKey()
+ *        skips to the next distinct key instead. Tombstones left by lazy
+ *        deletion have no copies and are skipped. The iterator keeps its
+ *        tree, so stepping back from end() reaches the largest key.
+ * @author William Susanto and Robel Messele
+ */
+#ifndef THREADEDBST_ITERATOR_
+#define THREADEDBST_ITERATOR_
+
+#include "BinaryNode.h"
+#include "TreeStats.h"
+#include <cstddef>
+#include <iterator>
+
+template <typename ItemType> class ThreadedBST;
+
+template <class ItemType> class ThreadedBSTIterator {
+private:
+  const ThreadedBST<ItemType> *tree; // Tree iterated, nullptr if unknown
+  BinaryNode<ItemType> *current;     // Node at this position, nullptr at end
+  int copy;                          // Copy of the node item, from 0
+
+public:
+  typedef std::bidirectional_iterator_tag iterator_category;
+  typedef ItemType value_type;
+  typedef std::ptrdiff_t difference_type;
+  typedef const ItemType *pointer;
+  typedef ItemType reference;
+
+  /**
+   * @brief Constructor
+   *
+   * @pre none
+   * @post end iterator of no tree, it cannot be decremented
+   */
+  ThreadedBSTIterator();
+
+  /**
+   * @brief Constructor
+   *
+   * @pre node is in owner or nullptr, copyIndex < its count
+   * @post iterator at copy copyIndex of node, end of owner if nullptr
+   * @param owner tree the node is in
+   * @param node node to start at
+   * @param copyIndex copy of the node item to start at
+   */
+  ThreadedBSTIterator(const ThreadedBST<ItemType> *owner,
+                      BinaryNode<ItemType> *node, int copyIndex = 0);
+
+  /**
+   * @brief Get item at this position
+   *
+   * @pre not the end iterator
+   * @post return node item
+   * @return ItemType node item
+   */
+  ItemType operator*() const;
+
+  /**
+   * @brief Get node at this position
+   *
+   * @pre none
+   * @post return node or nullptr at end
+   * @return BinaryNode<ItemType>* node
+   */
+  BinaryNode<ItemType> *getNode() const;
+
+  /**
+   * @brief Get number of copies of the item at this position
+   *
+   * @pre not the end iterator
+   * @post return copies held by the node
+   * @return int number of copies
+   */
+  int getCount() const;
+
+  /**
+   * @brief Get which copy of the item this position is at
+   *
+   * @pre none
+   * @post return copy index, 0 at end
+   * @return int copy index, from 0
+   */
+  int getCopy() const;
+
+  /**
+   * @brief Move to the next distinct key
+   *
+   * @pre not the end iterator
+   * @post iterator at first copy of the successor node or end
+   * @return ThreadedBSTIterator& this iterator
+   */
+  ThreadedBSTIterator<ItemType> &nextKey();
+
+  /**
+   * @brief Move to inorder successor
+   *
+   * @pre not the end iterator
+   * @post iterator at next copy, successor or end
+   * @return ThreadedBSTIterator& this iterator
+   */
+  ThreadedBSTIterator<ItemType> &operator++();
+
+  /**
+   * @brief Move to inorder successor
+   *
+   * @pre not the end iterator
+   * @post iterator at next copy, successor or end
+   * @return ThreadedBSTIterator iterator before moving
+   */
+  ThreadedBSTIterator<ItemType> operator++(int);
+
+  /**
+   * @brief Move to inorder predecessor
+   *
+   * @pre not the end iterator of no tree
+   * @post iterator at previous copy or last copy of predecessor, end if
+   *       at the smallest node, last copy of the largest key if at end
+   * @return ThreadedBSTIterator& this iterator
+   */
+  ThreadedBSTIterator<ItemType> &operator--();
+
+  /**
+   * @brief Move to inorder predecessor
+   *
+   * @pre not the end iterator of no tree
+   * @post iterator at previous copy or last copy of predecessor, end if
+   *       at the smallest node, last copy of the largest key if at end
+   * @return ThreadedBSTIterator iterator before moving
+   */
+  ThreadedBSTIterator<ItemType> operator--(int);
+
+  /**
+   * @brief Compare positions
+   *
+   * @pre none
+   * @post return if both are at the same copy of the same node
+   * @param other iterator to compare with
+   * @return bool true if equal
+   */
+  bool operator==(const ThreadedBSTIterator<ItemType> &other) const;
+
+  /**
+   * @brief Compare positions
+   *
+   * @pre none
+   * @post return if iterators are at different nodes or copies
+   * @param other iterator to compare with
+   * @return bool true if not equal
+   */
+  bool operator!=(const ThreadedBSTIterator<ItemType> &other) const;
+}; // end ThreadedBSTIterator
+
+#include "ThreadedBSTIterator.cpp"
+#endif
@@ -0,0 +1,355 @@
+/**
+ * @file TraceReplayer.cpp
+ * @brief TraceReplayer header that declares TraceReplayer class
+ * @author William Susanto and Robel Messele
+ */
+#include "TraceReplayer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+/**
+ * @brief Checks an operation against the key type of the tree
+ *
+ * @pre none
+ * @post returns if the tree can hold the key of op, the end key of a
+ *       scan is only compared against and may lie outside
+ * @param op operation to check
+ * @return bool true if the key fits
+ */
+template <class TreeType>
+bool TraceReplayer<TreeType>::keyFits(const TraceOp &op) const {
+  if constexpr (is_integral<KeyType>::value) {
+    // Negative keys only fit a signed type, the rest are compared unsigned
+    // so neither side is cut
+    if (op.key < 0) {
+      return is_signed<KeyType>::value &&
+             op.key >= (long long)numeric_limits<KeyType>::min();
+    }
+    return (unsigned long long)op.key <=
+           (unsigned long long)numeric_limits<KeyType>::max();
+  } else {
+    return true;
+  }
+}
+
+/**
+ * @brief Parse a text trace
+ *
+ * @pre input is open
+ * @post ops holds the parsed operations
+ * @param input stream to read from
+ * @return bool false on a malformed line
+ */
+template <class TreeType>
+bool TraceReplayer<TreeType>::loadText(istream &input) {
+  string line;
+  long long lineNumber = 0;
+  while (getline(input, line)) {
+    lineNumber++;
+    // Skip blank lines and comments
+    size_t first = line.find_first_not_of(" \t\r");
+    if (first == string::npos || line[first] == '#') {
+      continue;
+    }
+    istringstream fields(line);
+    TraceOp op;
+    char type;
+    if (!(fields >> op.timestamp >> type >> op.key)) {
+      error = "line " + to_string(lineNumber) + ": malformed operation";
+      return false;
+    }
+    op.endKey = op.key;
+    switch (type) {
+    case 'I':
+      op.type = OP_INSERT;
+      break;
+    case 'R':
+      op.type = OP_REMOVE;
+      break;
+    case 'L':
+      op.type = OP_LOOKUP;
+      break;
+    case 'S':
+      op.type = OP_SCAN;
+      if (!(fields >> op.endKey)) {
+        error = "line " + to_string(lineNumber) + ": scan without end key";
+        return false;
+      }
+      break;
+    default:
+      error = "line " + to_string(lineNumber) + ": unknown operation";
+      return false;
+    }
+    if (!keyFits(op)) {
+      error = "line " + to_string(lineNumber) + ": key " + to_string(op.key) +
+              " is out of range of the tree's key type";
+      return false;
+    }
+    ops.push_back(op);
+  }
+  return true;
+}
+
+/**
+ * @brief Parse a binary trace
+ *
+ * @pre input is open and past the magic
+ * @post ops holds the parsed operations
+ * @param input stream to read from
+ * @return bool false on a truncated record
+ */
+template <class TreeType>
+bool TraceReplayer<TreeType>::loadBinary(istream &input) {
+  unsigned char record[25];
+  while (input.read((char *)record, sizeof(record))) {
+    // Fields are little endian regardless of host order
+    unsigned long long fields[3] = {0, 0, 0};
+    const int offsets[3] = {0, 9, 17};
+    for (int f = 0; f < 3; f++) {
+      for (int b = 7; b >= 0; b--) {
+        fields[f] = (fields[f] << 8) | record[offsets[f] + b];
+      }
+    }
+    if (record[8] >= OP_TYPES) {
+      error = "record " + to_string(ops.size()) + ": unknown operation";
+      return false;
+    }
+    TraceOp op;
+    op.timestamp = (long long)fields[0];
+    op.type = (TraceOpType)record[8];
+    op.key = (long long)fields[1];
+    op.endKey = (long long)fields[2];
+    if (!keyFits(op)) {
+      error = "record " + to_string(ops.size()) + ": key " +
+              to_string(op.key) + " is out of range of the tree's key type";
+      return false;
+    }
+    ops.push_back(op);
+  }
+  // Anything left over is a partial record
+  if (input.gcount() != 0) {
+    error = "record " + to_string(ops.size()) + ": truncated";
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Run a single operation
+ *
+ * @pre none
+ * @post operation applied to tree
+ * @param tree tree to run against
+ * @param op operation to run
+ */
+template <class TreeType>
+void TraceReplayer<TreeType>::run(TreeType &tree, const TraceOp &op) {
+  switch (op.type) {
+  case OP_INSERT:
+    tree.add(nullptr, op.key);
+    break;
+  case OP_REMOVE:
+    tree.erase(op.key);
+    break;
+  case OP_LOOKUP:
+    hits += tree.contains(op.key);
+    break;
+  case OP_SCAN:
+    // Walk the successor threads from the lower bound, the iterator skips
+    // tombstones and visits every counted copy
+    for (typename TreeType::iterator it(&tree, tree.lowerBound(op.key));
+         it != tree.end() && *it < op.endKey; ++it) {
+      hits++;
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+/**
+ * @brief Load a text or binary trace
+ *
+ * @pre none
+ * @post trace is loaded, format picked from the file magic
+ * @param fileName trace file
+ * @return bool false if the file cannot be read or parsed
+ */
+template <class TreeType>
+bool TraceReplayer<TreeType>::load(const string &fileName) {
+  ifstream input(fileName, ios::binary);
+  if (!input) {
+    error = "cannot open " + fileName;
+    return false;
+  }
+  return load(input);
+}
+
+/**
+ * @brief Load a text or binary trace from a stream
+ *
+ * @pre input is open at the start of the trace
+ * @post trace is loaded, format picked from the magic
+ * @param input stream to read from
+ * @return bool false if the trace cannot be parsed
+ */
+template <class TreeType> bool TraceReplayer<TreeType>::load(istream &input) {
+  error.clear();
+  ops.clear();
+  const streampos start = input.tellg();
+  char magic[8];
+  if (input.read(magic, sizeof(magic)) && memcmp(magic, "TBSTTRC1", 8) == 0) {
+    return loadBinary(input);
+  }
+  input.clear();
+  input.seekg(start);
+  return loadText(input);
+}
+
+/**
+ * @brief Get why the last load failed
+ *
+ * @pre none
+ * @post return message naming the line or record, empty after a
+ *       successful load
+ * @return const string& error message
+ */
+template <class TreeType>
+const string &TraceReplayer<TreeType>::getError() const {
+  return error;
+}
+
+/**
+ * @brief Write the loaded trace in binary format
+ *
+ * @pre none
+ * @post binary trace written to file
+ * @param fileName file to write
+ * @return bool false if the file cannot be written
+ */
+template <class TreeType>
+bool TraceReplayer<TreeType>::saveBinary(const string &fileName) const {
+  ofstream output(fileName, ios::binary);
+  if (!output) {
+    return false;
+  }
+  output.write("TBSTTRC1", 8);
+  unsigned char record[25];
+  for (const TraceOp &op : ops) {
+    const unsigned long long fields[3] = {(unsigned long long)op.timestamp,
+                                          (unsigned long long)op.key,
+                                          (unsigned long long)op.endKey};
+    const int offsets[3] = {0, 9, 17};
+    for (int f = 0; f < 3; f++) {
+      for (int b = 0; b < 8; b++) {
+        record[offsets[f] + b] = (unsigned char)(fields[f] >> (8 * b));
+      }
+    }
+    record[8] = (unsigned char)op.type;
+    output.write((const char *)record, sizeof(record));
+  }
+  return (bool)output;
+}
+
+/**
+ * @brief Get number of loaded operations
+ *
+ * @pre none
+ * @post return number of operations
+ * @return size_t number of operations
+ */
+template <class TreeType> size_t TraceReplayer<TreeType>::size() const {
+  return ops.size();
+}
+
+/**
+ * @brief Replay the loaded trace
+ *
+ * @pre none
+ * @post trace is applied to tree and latencies are recorded
+ * @param tree tree to run against
+ * @param speed 0 for full speed, otherwise multiple of the recorded rate
+ */
+template <class TreeType>
+void TraceReplayer<TreeType>::replay(TreeType &tree, double speed) {
+  using Clock = chrono::steady_clock;
+  for (int type = 0; type < OP_TYPES; type++) {
+    latencies[type].clear();
+  }
+  hits = 0;
+  if (ops.empty()) {
+    elapsed = 0;
+    return;
+  }
+
+  const long long firstStamp = ops.front().timestamp;
+  const Clock::time_point start = Clock::now();
+  for (const TraceOp &op : ops) {
+    // Hold back until the op is due when pacing to the recorded rate
+    if (speed > 0) {
+      this_thread::sleep_until(
+          start + chrono::nanoseconds(
+                      (long long)((op.timestamp - firstStamp) / speed)));
+    }
+    const Clock::time_point before = Clock::now();
+    run(tree, op);
+    const Clock::time_point after = Clock::now();
+    latencies[op.type].push_back(
+        chrono::duration_cast<chrono::nanoseconds>(after - before).count());
+  }
+  elapsed =
+      chrono::duration_cast<chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+/**
+ * @brief Outputs throughput and latency percentiles per operation type
+ *
+ * @pre replay has run
+ * @post report written to output
+ * @param output stream to write to
+ */
+template <class TreeType>
+void TraceReplayer<TreeType>::report(ostream &output) const {
+  static const char *names[OP_TYPES] = {"insert", "remove", "lookup", "scan"};
+  static const double percentiles[] = {0.50, 0.90, 0.99, 0.999};
+
+  size_t total = 0;
+  for (int type = 0; type < OP_TYPES; type++) {
+    total += latencies[type].size();
+  }
+  const double seconds = elapsed / 1e9;
+  output << total << " ops in " << fixed << setprecision(3) << seconds
+         << " s, " << setprecision(0) << (seconds > 0 ? total / seconds : 0)
+         << " ops/s" << endl;
+  output << left << setw(8) << "op" << right << setw(10) << "count"
+         << setw(12) << "ops/s" << setw(10) << "p50" << setw(10) << "p90"
+         << setw(10) << "p99" << setw(10) << "p99.9" << setw(10) << "max"
+         << "  (ns)" << endl;
+
+  for (int type = 0; type < OP_TYPES; type++) {
+    if (latencies[type].empty()) {
+      continue;
+    }
+    vector<long long> sorted(latencies[type]);
+    sort(sorted.begin(), sorted.end());
+    long long busy = 0;
+    for (long long latency : sorted) {
+      busy += latency;
+    }
+    // Throughput while running this op type only
+    output << left << setw(8) << names[type] << right << setw(10)
+           << sorted.size() << setw(12)
+           << (busy > 0 ? sorted.size() * 1e9 / busy : 0);
+    for (double p : percentiles) {
+      size_t rank = (size_t)(p * sorted.size());
+      output << setw(10) << sorted[min(rank, sorted.size() - 1)];
+    }
+    output << setw(10) << sorted.back() << endl;
+  }
+  output << "lookup hits and scanned keys: " << hits << endl;
+}
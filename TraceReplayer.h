@@ -0,0 +1,160 @@
+/**
+ * @file TraceReplayer.h
+ * @brief TraceReplayer header that declares TraceReplayer class.
+ *        Replays recorded operation traces against a tree and reports
+ *        throughput and latency percentiles per operation type.
+ *
+ *        Text traces hold one operation per line, blank lines and lines
+ *        starting with '#' are skipped:
+ *          <timestamp ns> <I|R|L|S> <key> [<end key for S>]
+ *        Binary traces start with the 8 byte magic "TBSTTRC1" followed by
+ *        25 byte little endian records:
+ *          int64 timestamp ns, uint8 op (0 I, 1 R, 2 L, 3 S), int64 key,
+ *          int64 end key
+ *        A scan visits every key in [key, end key). A key the tree's key
+ *        type cannot hold fails the load instead of being truncated.
+ * @author William Susanto and Robel Messele
+ */
+#ifndef TRACE_REPLAYER_
+#define TRACE_REPLAYER_
+
+#include <iostream>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using namespace std;
+
+enum TraceOpType { OP_INSERT, OP_REMOVE, OP_LOOKUP, OP_SCAN, OP_TYPES };
+
+struct TraceOp {
+  long long timestamp; // Recorded time in nanoseconds
+  TraceOpType type;    // Operation to run
+  long long key;       // Key, or start of a scan
+  long long endKey;    // End of a scan (exclusive)
+};
+
+template <class TreeType> class TraceReplayer {
+private:
+  typedef typename TreeType::iterator::value_type KeyType;
+
+  vector<TraceOp> ops;                   // Loaded trace
+  vector<long long> latencies[OP_TYPES]; // Nanoseconds per replayed op
+  long long elapsed = 0;                 // Nanoseconds for whole replay
+  long long hits = 0;                    // Lookup hits and scanned keys
+  string error;                          // Why the last load failed
+
+  /**
+   * @brief Checks an operation against the key type of the tree
+   *
+   * @pre none
+   * @post returns if the tree can hold the key of op, the end key of a
+   *       scan is only compared against and may lie outside
+   * @param op operation to check
+   * @return bool true if the key fits
+   */
+  bool keyFits(const TraceOp &op) const;
+
+  /**
+   * @brief Parse a text trace
+   *
+   * @pre input is open
+   * @post ops holds the parsed operations
+   * @param input stream to read from
+   * @return bool false on a malformed line
+   */
+  bool loadText(istream &input);
+
+  /**
+   * @brief Parse a binary trace
+   *
+   * @pre input is open and past the magic
+   * @post ops holds the parsed operations
+   * @param input stream to read from
+   * @return bool false on a truncated record
+   */
+  bool loadBinary(istream &input);
+
+  /**
+   * @brief Run a single operation
+   *
+   * @pre none
+   * @post operation applied to tree
+   * @param tree tree to run against
+   * @param op operation to run
+   */
+  void run(TreeType &tree, const TraceOp &op);
+
+public:
+  /**
+   * @brief Load a text or binary trace
+   *
+   * @pre none
+   * @post trace is loaded, format picked from the file magic
+   * @param fileName trace file
+   * @return bool false if the file cannot be read or parsed
+   */
+  bool load(const string &fileName);
+
+  /**
+   * @brief Load a text or binary trace from a stream
+   *
+   * @pre input is open at the start of the trace
+   * @post trace is loaded, format picked from the magic
+   * @param input stream to read from
+   * @return bool false if the trace cannot be parsed
+   */
+  bool load(istream &input);
+
+  /**
+   * @brief Get why the last load failed
+   *
+   * @pre none
+   * @post return message naming the line or record, empty after a
+   *       successful load
+   * @return const string& error message
+   */
+  const string &getError() const;
+
+  /**
+   * @brief Write the loaded trace in binary format
+   *
+   * @pre none
+   * @post binary trace written to file
+   * @param fileName file to write
+   * @return bool false if the file cannot be written
+   */
+  bool saveBinary(const string &fileName) const;
+
+  /**
+   * @brief Get number of loaded operations
+   *
+   * @pre none
+   * @post return number of operations
+   * @return size_t number of operations
+   */
+  size_t size() const;
+
+  /**
+   * @brief Replay the loaded trace
+   *
+   * @pre none
+   * @post trace is applied to tree and latencies are recorded
+   * @param tree tree to run against
+   * @param speed 0 for full speed, otherwise multiple of the recorded rate
+   */
+  void replay(TreeType &tree, double speed);
+
+  /**
+   * @brief Outputs throughput and latency percentiles per operation type
+   *
+   * @pre replay has run
+   * @post report written to output
+   * @param output stream to write to
+   */
+  void report(ostream &output) const;
+}; // end TraceReplayer
+
+#include "TraceReplayer.cpp"
+#endif
@@ -0,0 +1,31 @@
+/**
+ * @file TreeShape.h
+ * @brief TreeShape header that declares TreeShape struct.
+ *        Structural statistics of a threaded BST, filled by
+ *        ThreadedBST::stats().
+ * @author William Susanto and Robel Messele
+ */
+#ifndef TREE_SHAPE_
+#define TREE_SHAPE_
+
+#include <cstddef>
+#include <vector>
+
+struct TreeShape {
+  int nodes = 0;                   // Number of nodes
+  int tombstones = 0;              // Nodes left behind by lazy deletion
+  int blockNodes = 0;              // Nodes in blocks made by compact()
+  int height = 0;                  // Levels, an empty tree has 0
+  double averagePathLength = 0;    // Nodes visited to find a key, on average
+  int maxPathLength = 0;           // Nodes visited to find the deepest key
+  std::vector<int> depthHistogram; // Nodes per level, root level first
+  int childLinks = 0;              // Pointers to a child
+  int threadLinks = 0;             // Pointers threaded to a neighbour
+  int nullLinks = 0;               // Empty pointers at both ends
+  size_t memoryBytes = 0;          // Estimated heap use, with malloc headers
+                                   // for nodes not in a block
+  double localityScore = 0;        // Average address distance in bytes between
+                                   // inorder neighbours, lower is better
+};
+
+#endif
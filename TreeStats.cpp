@@ -0,0 +1,406 @@
+/**
+ * @file TreeStats.cpp
+ * @brief TreeStats header that declares TreeStats class
+ * @author William Susanto and Robel Messele
+ */
+#include "TreeStats.h"
+#include <cmath>
+
+#ifdef THREADEDBST_PERF
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Get bucket of a value
+ *
+ * @pre none
+ * @post return bucket index
+ * @param value value to place
+ * @return int bucket index
+ */
+inline int LatencyHistogram::bucketOf(uint64_t value) {
+  if (value < (uint64_t)SUB_BUCKETS) {
+    return (int)value;
+  }
+  // Position of the highest set bit picks the power of two
+#if defined(__GNUC__)
+  int exponent = 63 - __builtin_clzll(value);
+#else
+  int exponent = 0;
+  while ((value >> exponent) > 1) {
+    exponent++;
+  }
+#endif
+  // The bits below it pick the sub bucket
+  int sub = (int)(value >> (exponent - SUB_BITS)) & (SUB_BUCKETS - 1);
+  return (exponent - SUB_BITS + 1) * SUB_BUCKETS + sub;
+}
+
+/**
+ * @brief Get smallest value of a bucket
+ *
+ * @pre 0 <= bucket < BUCKETS
+ * @post return lower bound of bucket
+ * @param bucket bucket index
+ * @return uint64_t smallest value in bucket
+ */
+inline uint64_t LatencyHistogram::valueOf(int bucket) {
+  if (bucket < SUB_BUCKETS) {
+    return (uint64_t)bucket;
+  }
+  int exponent = bucket / SUB_BUCKETS + SUB_BITS - 1;
+  uint64_t sub = (uint64_t)(bucket % SUB_BUCKETS);
+  return ((uint64_t)SUB_BUCKETS + sub) << (exponent - SUB_BITS);
+}
+
+/**
+ * @brief Constructor
+ *
+ * @pre none
+ * @post empty histogram
+ */
+inline LatencyHistogram::LatencyHistogram() { reset(); }
+
+/**
+ * @brief Record a value
+ *
+ * @pre none
+ * @post value counted in its bucket
+ * @param value value to record
+ */
+inline void LatencyHistogram::record(uint64_t value) {
+  buckets[bucketOf(value)].fetch_add(1, memory_order_relaxed);
+  total.fetch_add(1, memory_order_relaxed);
+  uint64_t largest = maxValue.load(memory_order_relaxed);
+  while (value > largest &&
+         !maxValue.compare_exchange_weak(largest, value,
+                                         memory_order_relaxed)) {
+  }
+}
+
+/**
+ * @brief Get number of recorded values
+ *
+ * @pre none
+ * @post return number of values
+ * @return uint64_t number of values
+ */
+inline uint64_t LatencyHistogram::getCount() const {
+  return total.load(memory_order_relaxed);
+}
+
+/**
+ * @brief Get value at a percentile
+ *
+ * @pre 0 <= fraction <= 1
+ * @post return lower bound of the bucket holding the percentile
+ * @param fraction percentile as a fraction
+ * @return uint64_t value at percentile
+ */
+inline uint64_t LatencyHistogram::percentile(double fraction) const {
+  uint64_t values = getCount();
+  if (values == 0) {
+    return 0;
+  }
+  uint64_t rank = (uint64_t)ceil(fraction * values);
+  if (rank == 0) {
+    rank = 1;
+  }
+  uint64_t seen = 0;
+  for (int bucket = 0; bucket < BUCKETS; bucket++) {
+    seen += buckets[bucket].load(memory_order_relaxed);
+    if (seen >= rank) {
+      return valueOf(bucket);
+    }
+  }
+  return getMax();
+}
+
+/**
+ * @brief Get largest recorded value
+ *
+ * @pre none
+ * @post return largest value
+ * @return uint64_t largest value
+ */
+inline uint64_t LatencyHistogram::getMax() const {
+  return maxValue.load(memory_order_relaxed);
+}
+
+/**
+ * @brief Empty histogram
+ *
+ * @pre none
+ * @post all buckets are zero
+ */
+inline void LatencyHistogram::reset() {
+  for (int bucket = 0; bucket < BUCKETS; bucket++) {
+    buckets[bucket].store(0, memory_order_relaxed);
+  }
+  total.store(0, memory_order_relaxed);
+  maxValue.store(0, memory_order_relaxed);
+}
+
+/**
+ * @brief Constructor
+ *
+ * @pre none
+ * @post all counters are zero
+ */
+inline TreeStats::TreeStats() { reset(); }
+
+#ifdef THREADEDBST_PERF
+/**
+ * @brief Constructor
+ *
+ * @pre none
+ * @post events of the calling thread are open and stopped
+ */
+inline TreeStats::PerfEvents::PerfEvents() {
+  const uint64_t events[2] = {PERF_COUNT_HW_CACHE_MISSES,
+                              PERF_COUNT_HW_BRANCH_MISSES};
+  for (int i = 0; i < 2; i++) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = events[i];
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fds[i] = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+  }
+}
+
+/**
+ * @brief Destructor
+ *
+ * @pre none
+ * @post events are closed
+ */
+inline TreeStats::PerfEvents::~PerfEvents() {
+  for (int i = 0; i < 2; i++) {
+    if (fds[i] >= 0) {
+      close(fds[i]);
+    }
+  }
+}
+
+/**
+ * @brief Get the events of the calling thread
+ *
+ * @pre none
+ * @post events are opened on first use in the thread
+ * @return PerfEvents& events of this thread
+ */
+inline TreeStats::PerfEvents &TreeStats::threadEvents() {
+  static thread_local PerfEvents events;
+  return events;
+}
+#endif
+
+/**
+ * @brief Get the process wide stats
+ *
+ * @pre none
+ * @post return stats shared by all trees
+ * @return TreeStats& stats
+ */
+inline TreeStats &TreeStats::global() {
+  static TreeStats stats;
+  return stats;
+}
+
+/**
+ * @brief Increment a counter
+ *
+ * @pre none
+ * @post counter is increased
+ * @param counter counter to increase
+ * @param amount amount to add
+ */
+inline void TreeStats::count(Counter counter, uint64_t amount) {
+  counters[counter].fetch_add(amount, memory_order_relaxed);
+}
+
+/**
+ * @brief Get a counter
+ *
+ * @pre none
+ * @post return counter value
+ * @param counter counter to read
+ * @return uint64_t counter value
+ */
+inline uint64_t TreeStats::get(Counter counter) const {
+  return counters[counter].load(memory_order_relaxed);
+}
+
+/**
+ * @brief Record latency of an operation
+ *
+ * @pre none
+ * @post latency counted in the histogram of the operation
+ * @param operation operation that ran
+ * @param nanoseconds latency
+ */
+inline void TreeStats::record(Operation operation, uint64_t nanoseconds) {
+  latencies[operation].record(nanoseconds);
+}
+
+/**
+ * @brief Get latency histogram of an operation
+ *
+ * @pre none
+ * @post return histogram
+ * @param operation operation to read
+ * @return const LatencyHistogram& histogram
+ */
+inline const LatencyHistogram &TreeStats::latency(Operation operation) const {
+  return latencies[operation];
+}
+
+/**
+ * @brief Start counting cache and branch misses of this thread
+ *
+ * @pre none
+ * @post hardware counters run, no-op without THREADEDBST_PERF
+ */
+inline void TreeStats::perfStart() {
+#ifdef THREADEDBST_PERF
+  const int *fds = threadEvents().fds;
+  for (int i = 0; i < 2; i++) {
+    if (fds[i] >= 0) {
+      perfOpened[i].store(true, memory_order_relaxed);
+      ioctl(fds[i], PERF_EVENT_IOC_RESET, 0);
+      ioctl(fds[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+#endif
+}
+
+/**
+ * @brief Stop counting and add the misses to the totals
+ *
+ * @pre perfStart was called
+ * @post totals are increased, no-op without THREADEDBST_PERF
+ */
+inline void TreeStats::perfStop() {
+#ifdef THREADEDBST_PERF
+  const int *fds = threadEvents().fds;
+  for (int i = 0; i < 2; i++) {
+    uint64_t value;
+    if (fds[i] >= 0) {
+      ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+      if (read(fds[i], &value, sizeof(value)) == sizeof(value)) {
+        perfTotals[i].fetch_add(value, memory_order_relaxed);
+      }
+    }
+  }
+#endif
+}
+
+/**
+ * @brief Zero every counter and histogram
+ *
+ * @pre none
+ * @post all stats are zero
+ */
+inline void TreeStats::reset() {
+  for (int counter = 0; counter < COUNTERS; counter++) {
+    counters[counter].store(0, memory_order_relaxed);
+  }
+  for (int op = 0; op < OPERATIONS; op++) {
+    latencies[op].reset();
+  }
+#ifdef THREADEDBST_PERF
+  for (int i = 0; i < 2; i++) {
+    perfTotals[i].store(0, memory_order_relaxed);
+    perfOpened[i].store(false, memory_order_relaxed);
+  }
+#endif
+}
+
+/**
+ * @brief Outputs stats as JSON
+ *
+ * @pre none
+ * @post JSON object written to output
+ * @param output stream to write to
+ */
+inline void TreeStats::toJson(ostream &output) const {
+  static const char *counterNames[COUNTERS] = {
+      "comparisons",   "nodes_visited", "child_follows", "thread_follows",
+      "remove_case_a", "remove_case_b", "remove_case_c"};
+  static const char *opNames[OPERATIONS] = {"add", "remove", "find", "succ"};
+
+  output << "{\"counters\":{";
+  for (int counter = 0; counter < COUNTERS; counter++) {
+    output << (counter ? "," : "") << "\"" << counterNames[counter]
+           << "\":" << get((Counter)counter);
+  }
+  output << "},\"latency_ns\":{";
+  for (int op = 0; op < OPERATIONS; op++) {
+    const LatencyHistogram &histogram = latencies[op];
+    output << (op ? "," : "") << "\"" << opNames[op] << "\":{"
+           << "\"count\":" << histogram.getCount()
+           << ",\"p50\":" << histogram.percentile(0.50)
+           << ",\"p90\":" << histogram.percentile(0.90)
+           << ",\"p99\":" << histogram.percentile(0.99)
+           << ",\"p999\":" << histogram.percentile(0.999)
+           << ",\"max\":" << histogram.getMax() << "}";
+  }
+  output << "}";
+#ifdef THREADEDBST_PERF
+  output << ",\"perf\":{";
+  output << "\"cache_misses\":";
+  if (perfOpened[0].load(memory_order_relaxed)) {
+    output << perfTotals[0].load(memory_order_relaxed);
+  } else {
+    output << "null";
+  }
+  output << ",\"branch_misses\":";
+  if (perfOpened[1].load(memory_order_relaxed)) {
+    output << perfTotals[1].load(memory_order_relaxed);
+  } else {
+    output << "null";
+  }
+  output << "}";
+#endif
+  output << "}";
+}
+
+/**
+ * @brief Constructor
+ *
+ * @pre none
+ * @post timer started, unless another one runs on this thread
+ * @param op operation to time
+ */
+inline TreeStatsTimer::TreeStatsTimer(TreeStats::Operation op) {
+  operation = op;
+  outermost = running++ == 0;
+  if (outermost) {
+    start = chrono::steady_clock::now();
+  }
+}
+
+/**
+ * @brief Destructor
+ *
+ * @pre none
+ * @post elapsed time recorded by the outermost timer
+ */
+inline TreeStatsTimer::~TreeStatsTimer() {
+  running--;
+  if (!outermost) {
+    return;
+  }
+  TreeStats::global().record(
+      operation, (uint64_t)chrono::duration_cast<chrono::nanoseconds>(
+                     chrono::steady_clock::now() - start)
+                     .count());
+}
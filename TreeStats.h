@@ -0,0 +1,311 @@
+/**
+ * @file TreeStats.h
+ * @brief TreeStats header that declares TreeStats class.
+ *        Opt-in instrumentation for the tree hot paths. Compile with
+ *        -DTHREADEDBST_STATS to count comparisons, visited nodes, thread
+ *        and child follows and removal cases, and to record per-operation
+ *        latency histograms. Add -DTHREADEDBST_PERF on Linux to also read
+ *        cache and branch misses around perfStart/perfStop, each thread
+ *        counting its own misses into shared totals.
+ *        Only the outermost timed operation of a thread records its
+ *        latency, so a find that calls lowerBound is one FIND sample.
+ *        Without THREADEDBST_STATS the macros expand to nothing.
+ * @author William Susanto and Robel Messele
+ */
+#ifndef TREE_STATS_
+#define TREE_STATS_
+
+#ifdef THREADEDBST_STATS
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+using namespace std;
+
+/**
+ * Latency histogram with HDR style log-linear buckets. Every power of two
+ * is split into SUB_BUCKETS buckets, so any recorded value is off by less
+ * than 1/SUB_BUCKETS. Buckets are atomics so threads record without locks.
+ */
+class LatencyHistogram {
+public:
+  static const int SUB_BITS = 4;
+  static const int SUB_BUCKETS = 1 << SUB_BITS;
+  static const int BUCKETS = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+private:
+  atomic<uint64_t> buckets[BUCKETS]; // Number of values per bucket
+  atomic<uint64_t> total;            // Number of values
+  atomic<uint64_t> maxValue;         // Largest value
+
+  /**
+   * @brief Get bucket of a value
+   *
+   * @pre none
+   * @post return bucket index
+   * @param value value to place
+   * @return int bucket index
+   */
+  static int bucketOf(uint64_t value);
+
+  /**
+   * @brief Get smallest value of a bucket
+   *
+   * @pre 0 <= bucket < BUCKETS
+   * @post return lower bound of bucket
+   * @param bucket bucket index
+   * @return uint64_t smallest value in bucket
+   */
+  static uint64_t valueOf(int bucket);
+
+public:
+  /**
+   * @brief Constructor
+   *
+   * @pre none
+   * @post empty histogram
+   */
+  LatencyHistogram();
+
+  /**
+   * @brief Record a value
+   *
+   * @pre none
+   * @post value counted in its bucket
+   * @param value value to record
+   */
+  void record(uint64_t value);
+
+  /**
+   * @brief Get number of recorded values
+   *
+   * @pre none
+   * @post return number of values
+   * @return uint64_t number of values
+   */
+  uint64_t getCount() const;
+
+  /**
+   * @brief Get value at a percentile
+   *
+   * @pre 0 <= fraction <= 1
+   * @post return lower bound of the bucket holding the percentile
+   * @param fraction percentile as a fraction
+   * @return uint64_t value at percentile
+   */
+  uint64_t percentile(double fraction) const;
+
+  /**
+   * @brief Get largest recorded value
+   *
+   * @pre none
+   * @post return largest value
+   * @return uint64_t largest value
+   */
+  uint64_t getMax() const;
+
+  /**
+   * @brief Empty histogram
+   *
+   * @pre none
+   * @post all buckets are zero
+   */
+  void reset();
+}; // end LatencyHistogram
+
+class TreeStats {
+public:
+  enum Counter {
+    COMPARISONS,
+    NODES_VISITED,
+    CHILD_FOLLOWS,
+    THREAD_FOLLOWS,
+    REMOVE_CASE_A,
+    REMOVE_CASE_B,
+    REMOVE_CASE_C,
+    COUNTERS
+  };
+  enum Operation { ADD, REMOVE, FIND, SUCC, OPERATIONS };
+
+private:
+  atomic<uint64_t> counters[COUNTERS];
+  LatencyHistogram latencies[OPERATIONS];
+#ifdef THREADEDBST_PERF
+  atomic<uint64_t> perfTotals[2]; // Misses counted between start and stop
+  atomic<bool> perfOpened[2];     // Some thread could open the event
+
+  /**
+   * Cache miss and branch miss events of one thread. perf_event_open with
+   * pid 0 counts only the thread that opens it, so every thread needs
+   * its own.
+   */
+  struct PerfEvents {
+    int fds[2]; // -1 if the kernel or its settings do not allow it
+
+    /**
+     * @brief Constructor
+     *
+     * @pre none
+     * @post events of the calling thread are open and stopped
+     */
+    PerfEvents();
+
+    /**
+     * @brief Destructor
+     *
+     * @pre none
+     * @post events are closed
+     */
+    ~PerfEvents();
+  };
+
+  /**
+   * @brief Get the events of the calling thread
+   *
+   * @pre none
+   * @post events are opened on first use in the thread
+   * @return PerfEvents& events of this thread
+   */
+  static PerfEvents &threadEvents();
+#endif
+
+public:
+  /**
+   * @brief Constructor
+   *
+   * @pre none
+   * @post all counters are zero
+   */
+  TreeStats();
+
+  /**
+   * @brief Get the process wide stats
+   *
+   * @pre none
+   * @post return stats shared by all trees
+   * @return TreeStats& stats
+   */
+  static TreeStats &global();
+
+  /**
+   * @brief Increment a counter
+   *
+   * @pre none
+   * @post counter is increased
+   * @param counter counter to increase
+   * @param amount amount to add
+   */
+  void count(Counter counter, uint64_t amount = 1);
+
+  /**
+   * @brief Get a counter
+   *
+   * @pre none
+   * @post return counter value
+   * @param counter counter to read
+   * @return uint64_t counter value
+   */
+  uint64_t get(Counter counter) const;
+
+  /**
+   * @brief Record latency of an operation
+   *
+   * @pre none
+   * @post latency counted in the histogram of the operation
+   * @param operation operation that ran
+   * @param nanoseconds latency
+   */
+  void record(Operation operation, uint64_t nanoseconds);
+
+  /**
+   * @brief Get latency histogram of an operation
+   *
+   * @pre none
+   * @post return histogram
+   * @param operation operation to read
+   * @return const LatencyHistogram& histogram
+   */
+  const LatencyHistogram &latency(Operation operation) const;
+
+  /**
+   * @brief Start counting cache and branch misses of this thread
+   *
+   * @pre none
+   * @post hardware counters run, no-op without THREADEDBST_PERF
+   */
+  void perfStart();
+
+  /**
+   * @brief Stop counting and add the misses to the totals
+   *
+   * @pre perfStart was called
+   * @post totals are increased, no-op without THREADEDBST_PERF
+   */
+  void perfStop();
+
+  /**
+   * @brief Zero every counter and histogram
+   *
+   * @pre none
+   * @post all stats are zero
+   */
+  void reset();
+
+  /**
+   * @brief Outputs stats as JSON
+   *
+   * @pre none
+   * @post JSON object written to output
+   * @param output stream to write to
+   */
+  void toJson(ostream &output) const;
+}; // end TreeStats
+
+/**
+ * Records the time from construction to destruction as one operation.
+ * A timer started while another runs on the same thread records nothing,
+ * its time is already part of the outer operation.
+ */
+class TreeStatsTimer {
+private:
+  inline static thread_local int running = 0; // Timers open on this thread
+  TreeStats::Operation operation;
+  chrono::steady_clock::time_point start;
+  bool outermost; // Records when it ends
+
+public:
+  /**
+   * @brief Constructor
+   *
+   * @pre none
+   * @post timer started, unless another one runs on this thread
+   * @param op operation to time
+   */
+  explicit TreeStatsTimer(TreeStats::Operation op);
+
+  /**
+   * @brief Destructor
+   *
+   * @pre none
+   * @post elapsed time recorded by the outermost timer
+   */
+  ~TreeStatsTimer();
+}; // end TreeStatsTimer
+
+#include "TreeStats.cpp"
+
+#define TBST_STAT(counter) TreeStats::global().count(TreeStats::counter)
+#define TBST_STAT_ADD(counter, amount)                                         \
+  TreeStats::global().count(TreeStats::counter, amount)
+#define TBST_TIMER(op) TreeStatsTimer treeStatsTimer(TreeStats::op)
+
+#else
+
+#define TBST_STAT(counter) ((void)0)
+#define TBST_STAT_ADD(counter, amount) ((void)0)
+#define TBST_TIMER(op) ((void)0)
+
+#endif
+#endif
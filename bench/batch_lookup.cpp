@@ -0,0 +1,61 @@
+/**
+ * @file batch_lookup.cpp
+ * @brief Compares containsBatch at different batch sizes with looping over
+ *        contains, on a tree much larger than the caches.
+ *        Build: g++ -std=c++17 -O2 -I.. batch_lookup.cpp -o batch_lookup
+ *        Run:   ./batch_lookup [nodes] [lookups]
+ * @author William Susanto and Robel Messele
+ */
+#include "ThreadedBST.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <random>
+#include <vector>
+
+int main(int argc, char *argv[]) {
+  const int nodes = argc > 1 ? atoi(argv[1]) : 1 << 22;
+  const size_t lookups = argc > 2 ? strtoul(argv[2], nullptr, 10) : 1 << 22;
+
+  // Keys 1 to nodes, looked up in random order so most steps miss cache
+  ThreadedBST<int> tree(nodes);
+  mt19937 rng(42);
+  uniform_int_distribution<int> pick(1, 2 * nodes); // about half are misses
+  vector<int> keys(lookups);
+  for (size_t i = 0; i < lookups; i++) {
+    keys[i] = pick(rng);
+  }
+  bool flags[4096];
+
+  using Clock = chrono::steady_clock;
+  cout << nodes << " nodes, " << lookups << " lookups" << endl;
+  cout << setw(8) << "batch" << setw(14) << "Mlookups/s" << setw(12) << "hits"
+       << endl;
+  cout << fixed << setprecision(2);
+
+  // Baseline, one search at a time
+  Clock::time_point start = Clock::now();
+  size_t hits = 0;
+  for (size_t i = 0; i < lookups; i++) {
+    hits += tree.contains(keys[i]);
+  }
+  double seconds = chrono::duration<double>(Clock::now() - start).count();
+  cout << setw(8) << "single" << setw(14) << lookups / seconds / 1e6
+       << setw(12) << hits << endl;
+
+  for (size_t batch = 1; batch <= 4096; batch *= 2) {
+    start = Clock::now();
+    hits = 0;
+    for (size_t i = 0; i < lookups; i += batch) {
+      size_t size = min(batch, lookups - i);
+      tree.containsBatch(&keys[i], size, flags);
+      for (size_t j = 0; j < size; j++) {
+        hits += flags[j];
+      }
+    }
+    seconds = chrono::duration<double>(Clock::now() - start).count();
+    cout << setw(8) << batch << setw(14) << lookups / seconds / 1e6
+         << setw(12) << hits << endl;
+  }
+  return 0;
+}
@@ -0,0 +1,98 @@
+/**
+ * @file bulk_export.cpp
+ * @brief Compares exporting every key with toVector, copyTo and fixed size
+ *        copyChunk buffers against pushing the keys of an iterator loop
+ *        into a vector, on a tree whose nodes are scattered in memory.
+ *        Build: g++ -std=c++17 -O2 -I.. bulk_export.cpp -o bulk_export
+ *        Run:   ./bulk_export [nodes] [chunk]
+ * @author William Susanto and Robel Messele
+ */
+#include "ThreadedBST.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <random>
+#include <vector>
+
+using Clock = chrono::steady_clock;
+
+/**
+ * @brief Print one result line
+ *
+ * @pre none
+ * @post name, throughput and checksum are written to cout
+ * @param name label of the run
+ * @param start time the run started
+ * @param keys number of keys exported
+ * @param sum sum of the keys, so the work is not optimized away
+ */
+void report(const char *name, Clock::time_point start, size_t keys,
+            long long sum) {
+  double seconds = chrono::duration<double>(Clock::now() - start).count();
+  cout << setw(10) << name << setw(12) << keys / seconds / 1e6 << setw(20)
+       << sum << endl;
+}
+
+int main(int argc, char *argv[]) {
+  const int nodes = argc > 1 ? atoi(argv[1]) : 1 << 22;
+  const size_t chunk = argc > 2 ? strtoul(argv[2], nullptr, 10) : 4096;
+
+  // Random insertion order spreads inorder neighbours over the heap
+  ThreadedBST<int> tree;
+  mt19937 rng(42);
+  vector<int> order(nodes);
+  for (int i = 0; i < nodes; i++) {
+    order[i] = i;
+  }
+  shuffle(order.begin(), order.end(), rng);
+  for (int key : order) {
+    tree.add(nullptr, key);
+  }
+
+  cout << nodes << " nodes, chunks of " << chunk << endl;
+  cout << setw(10) << "export" << setw(12) << "Mkeys/s" << setw(20) << "sum"
+       << endl;
+  cout << fixed << setprecision(2);
+
+  Clock::time_point start = Clock::now();
+  vector<int> pushed;
+  for (auto it = tree.begin(); it != tree.end(); ++it) {
+    pushed.push_back(*it);
+  }
+  long long sum = 0;
+  for (int key : pushed) {
+    sum += key;
+  }
+  report("iterator", start, pushed.size(), sum);
+
+  start = Clock::now();
+  vector<int> keys = tree.toVector();
+  sum = 0;
+  for (int key : keys) {
+    sum += key;
+  }
+  report("toVector", start, keys.size(), sum);
+
+  start = Clock::now();
+  size_t size = tree.copyTo(keys.data(), keys.size());
+  sum = 0;
+  for (size_t i = 0; i < size; i++) {
+    sum += keys[i];
+  }
+  report("copyTo", start, size, sum);
+
+  // Only one small buffer is ever allocated
+  start = Clock::now();
+  vector<int> buffer(chunk);
+  ThreadedBST<int>::iterator from = tree.begin();
+  size = 0;
+  sum = 0;
+  for (size_t got; (got = tree.copyChunk(from, buffer.data(), chunk)) > 0;) {
+    for (size_t i = 0; i < got; i++) {
+      sum += buffer[i];
+    }
+    size += got;
+  }
+  report("copyChunk", start, size, sum);
+  return 0;
+}
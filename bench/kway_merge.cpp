@@ -0,0 +1,81 @@
+/**
+ * @file kway_merge.cpp
+ * @brief Compares a MergeIterator scan over 2 to 1024 trees with copying
+ *        every tree into one vector and sorting it. The total number of
+ *        keys stays the same, spread over more trees.
+ *        Build: g++ -std=c++17 -O2 -I.. kway_merge.cpp -o kway_merge
+ *        Run:   ./kway_merge [keys]
+ * @author William Susanto and Robel Messele
+ */
+#include "MergeIterator.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <random>
+#include <vector>
+
+using Clock = chrono::steady_clock;
+
+int main(int argc, char *argv[]) {
+  const int keys = argc > 1 ? atoi(argv[1]) : 1 << 22;
+  mt19937 rng(42);
+  uniform_int_distribution<int> pick(0, keys);
+
+  cout << keys << " keys" << endl;
+  cout << setw(8) << "inputs" << setw(14) << "merge Mk/s" << setw(14)
+       << "unique Mk/s" << setw(14) << "sort Mk/s" << endl;
+  cout << fixed << setprecision(2);
+
+  for (int inputs = 2; inputs <= 1024; inputs *= 2) {
+    // Partitions are loaded and then compacted, as a read mostly store
+    // would keep them
+    vector<ThreadedBST<int>> trees(inputs);
+    for (int i = 0; i < keys; i++) {
+      trees[i % inputs].add(nullptr, pick(rng));
+    }
+    vector<const ThreadedBST<int> *> parts;
+    for (ThreadedBST<int> &tree : trees) {
+      tree.compact();
+      parts.push_back(&tree);
+    }
+
+    Clock::time_point start = Clock::now();
+    long long mergedSum = 0;
+    for (MergeIterator<int> merged(parts); merged != MergeIterator<int>();
+         ++merged) {
+      mergedSum += *merged;
+    }
+    double mergeSeconds =
+        chrono::duration<double>(Clock::now() - start).count();
+
+    start = Clock::now();
+    long long uniqueSum = 0;
+    for (MergeIterator<int> merged(parts, true);
+         merged != MergeIterator<int>(); ++merged) {
+      uniqueSum += *merged;
+    }
+    double uniqueSeconds =
+        chrono::duration<double>(Clock::now() - start).count();
+
+    start = Clock::now();
+    vector<int> all(keys);
+    size_t size = 0;
+    for (const ThreadedBST<int> *tree : parts) {
+      size += tree->copyTo(all.data() + size, all.size() - size);
+    }
+    sort(all.begin(), all.end());
+    long long sortedSum = 0;
+    for (int key : all) {
+      sortedSum += key;
+    }
+    double sortSeconds = chrono::duration<double>(Clock::now() - start).count();
+
+    cout << setw(8) << inputs << setw(14) << keys / mergeSeconds / 1e6
+         << setw(14) << keys / uniqueSeconds / 1e6 << setw(14)
+         << keys / sortSeconds / 1e6
+         << (mergedSum == sortedSum && uniqueSum <= mergedSum ? "" : "  bad")
+         << endl;
+  }
+  return 0;
+}
@@ -0,0 +1,89 @@
+/**
+ * @file negative_lookup.cpp
+ * @brief Compares contains and containsRange with and without the lookup
+ *        filters when most lookups miss, on a tree much larger than the
+ *        caches.
+ *        Build: g++ -std=c++17 -O2 -I.. negative_lookup.cpp -o
+ *               negative_lookup
+ *        Run:   ./negative_lookup [nodes] [lookups] [hit percent]
+ * @author William Susanto and Robel Messele
+ */
+#include "ThreadedBST.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <random>
+#include <vector>
+
+/**
+ * @brief Time point and range lookups on a tree
+ *
+ * @pre none
+ * @post one line of results is written to cout
+ * @param name label of the run
+ * @param tree tree to search
+ * @param keys keys to look up, ranges start at them
+ */
+void run(const char *name, const ThreadedBST<int> &tree,
+         const vector<int> &keys) {
+  using Clock = chrono::steady_clock;
+  Clock::time_point start = Clock::now();
+  size_t hits = 0;
+  for (int key : keys) {
+    hits += tree.contains(key);
+  }
+  double seconds = chrono::duration<double>(Clock::now() - start).count();
+  cout << setw(10) << name << setw(14) << keys.size() / seconds / 1e6
+       << setw(10) << hits;
+
+  start = Clock::now();
+  hits = 0;
+  for (int key : keys) {
+    hits += tree.containsRange(key, key + 8);
+  }
+  seconds = chrono::duration<double>(Clock::now() - start).count();
+  cout << setw(14) << keys.size() / seconds / 1e6 << setw(10) << hits << endl;
+}
+
+int main(int argc, char *argv[]) {
+  const int nodes = argc > 1 ? atoi(argv[1]) : 1 << 22;
+  const size_t lookups = argc > 2 ? strtoul(argv[2], nullptr, 10) : 1 << 22;
+  const int hitPercent = argc > 3 ? atoi(argv[3]) : 5;
+
+  // Keys are multiples of 64, so a miss is any other number and a range of
+  // 8 starting at a miss is usually empty
+  ThreadedBST<int> tree;
+  mt19937 rng(42);
+  vector<int> order(nodes);
+  for (int i = 0; i < nodes; i++) {
+    order[i] = 64 * (i + 1);
+  }
+  shuffle(order.begin(), order.end(), rng);
+  for (int key : order) {
+    tree.add(nullptr, key);
+  }
+  tree.compact();
+
+  uniform_int_distribution<int> pick(1, nodes);
+  uniform_int_distribution<int> percent(0, 99);
+  vector<int> keys(lookups);
+  for (size_t i = 0; i < lookups; i++) {
+    const int slot = 64 * pick(rng);
+    keys[i] = percent(rng) < hitPercent ? slot : slot + 16 + percent(rng) % 32;
+  }
+
+  cout << nodes << " nodes, " << lookups << " lookups, " << hitPercent
+       << "% hits" << endl;
+  cout << setw(10) << "filter" << setw(14) << "Mcontains/s" << setw(10)
+       << "hits" << setw(14) << "Mranges/s" << setw(10) << "hits" << endl;
+  cout << fixed << setprecision(2);
+
+  run("none", tree, keys);
+  ThreadedBST<int> filtered(tree);
+  filtered.setFilter(true);
+  run("bloom", filtered, keys);
+  ThreadedBST<int> ranged(tree);
+  ranged.setFilter(true, 10, 3);
+  run("range", ranged, keys);
+  return 0;
+}
@@ -0,0 +1,127 @@
+/**
+ * @file snapshot_iteration.cpp
+ * @brief Measures PersistentBST snapshots against copying a ThreadedBST,
+ *        the cost of path copying on add, and how much slower in order
+ *        iteration over a version is with a stack than over threads.
+ *        Build: g++ -std=c++17 -O2 -I.. snapshot_iteration.cpp -o
+ *               snapshot_iteration
+ *        Run:   ./snapshot_iteration [nodes]
+ * @author William Susanto and Robel Messele
+ */
+#include "PersistentBST.h"
+#include "ThreadedBST.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <random>
+#include <vector>
+
+using Clock = chrono::steady_clock;
+
+/**
+ * @brief Get seconds since a time point
+ *
+ * @pre none
+ * @post return elapsed seconds
+ * @param start time point to measure from
+ * @return double seconds
+ */
+double since(Clock::time_point start) {
+  return chrono::duration<double>(Clock::now() - start).count();
+}
+
+/**
+ * @brief Time a full in order pass over a tree
+ *
+ * @pre none
+ * @post one result line is written to cout
+ * @param name label of the run
+ * @param tree tree to iterate
+ */
+template <class TreeType> void iterate(const char *name, const TreeType &tree) {
+  Clock::time_point start = Clock::now();
+  long long sum = 0;
+  size_t keys = 0;
+  for (auto it = tree.begin(); it != tree.end(); ++it) {
+    sum += *it;
+    keys++;
+  }
+  double seconds = since(start);
+  cout << setw(24) << name << setw(12) << keys / seconds / 1e6 << " Mkeys/s"
+       << setw(18) << sum << endl;
+}
+
+int main(int argc, char *argv[]) {
+  const int nodes = argc > 1 ? atoi(argv[1]) : 1 << 21;
+  mt19937 rng(42);
+  vector<int> order(nodes);
+  for (int i = 0; i < nodes; i++) {
+    order[i] = i;
+  }
+  shuffle(order.begin(), order.end(), rng);
+  cout << nodes << " nodes" << endl << fixed << setprecision(2);
+
+  // Adds with nothing shared change nodes in place, adds after every
+  // snapshot copy the whole path
+  ThreadedBST<int> threaded;
+  Clock::time_point start = Clock::now();
+  for (int key : order) {
+    threaded.add(nullptr, key);
+  }
+  cout << setw(24) << "ThreadedBST add" << setw(12) << nodes / since(start) / 1e6
+       << " Mops/s" << endl;
+
+  PersistentBST<int> head;
+  start = Clock::now();
+  for (int key : order) {
+    head.add(key);
+  }
+  cout << setw(24) << "PersistentBST add" << setw(12)
+       << nodes / since(start) / 1e6 << " Mops/s" << endl;
+
+  PersistentBST<int> copied;
+  vector<PersistentBST<int>> kept;
+  start = Clock::now();
+  for (int i = 0; i < nodes; i++) {
+    PersistentBST<int> version = copied.snapshot();
+    copied.add(order[i]);
+    // Keep a few versions alive so their nodes are not reused
+    if (i % 4096 == 0) {
+      kept.push_back(version);
+    }
+  }
+  cout << setw(24) << "add after each snapshot" << setw(12)
+       << nodes / since(start) / 1e6 << " Mops/s" << endl;
+  kept.clear();
+
+  start = Clock::now();
+  const int snapshots = 1000000;
+  for (int i = 0; i < snapshots; i++) {
+    PersistentBST<int> version = head.snapshot();
+  }
+  cout << setw(24) << "snapshot" << setw(12)
+       << since(start) / snapshots * 1e9 << " ns" << endl;
+  start = Clock::now();
+  {
+    ThreadedBST<int> copy(threaded);
+  }
+  cout << setw(24) << "ThreadedBST copy" << setw(12) << since(start) * 1e3
+       << " ms" << endl;
+
+  iterate("ThreadedBST", threaded);
+  ThreadedBST<int> compacted(threaded);
+  compacted.compact();
+  iterate("ThreadedBST compacted", compacted);
+  iterate("PersistentBST", head);
+
+  // Churn a tenth of the keys so the old version shares most nodes with
+  // the head but its changed paths sit elsewhere in memory
+  PersistentBST<int> old = head.snapshot();
+  for (int i = 0; i < nodes / 10; i++) {
+    head.erase(order[i]);
+    head.add(order[i]);
+  }
+  iterate("PersistentBST snapshot", old);
+  iterate("PersistentBST after churn", head);
+  return 0;
+}
@@ -0,0 +1,114 @@
+/**
+ * @file zipf_splay.cpp
+ * @brief Compares lookup throughput of the access modes on Zipf distributed
+ *        keys. The unbalanced tree is built by adding keys in random order,
+ *        the balanced one is the same tree after compact(), and the splay
+ *        trees start from the unbalanced shape and adapt while looking up.
+ *        Build: g++ -std=c++17 -O2 -I.. zipf_splay.cpp -o zipf_splay
+ *        Run:   ./zipf_splay [nodes] [lookups]
+ * @author William Susanto and Robel Messele
+ */
+#include "ThreadedBST.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <random>
+#include <vector>
+
+/**
+ * @brief Draw ranks from a Zipf distribution
+ *
+ * @pre nodes > 0
+ * @post ranks holds lookups ranks from 0 to nodes - 1, rank r drawn with
+ *       probability proportional to 1 / (r + 1)^skew
+ * @param nodes number of ranks
+ * @param lookups number of draws
+ * @param skew Zipf exponent
+ * @param rng random source
+ * @return vector<int> drawn ranks
+ */
+vector<int> zipfRanks(int nodes, size_t lookups, double skew, mt19937 &rng) {
+  vector<double> cumulative(nodes);
+  double total = 0;
+  for (int r = 0; r < nodes; r++) {
+    total += 1.0 / pow(r + 1.0, skew);
+    cumulative[r] = total;
+  }
+  uniform_real_distribution<double> pick(0, total);
+  vector<int> ranks(lookups);
+  for (size_t i = 0; i < lookups; i++) {
+    ranks[i] = (int)(lower_bound(cumulative.begin(), cumulative.end(),
+                                 pick(rng)) -
+                     cumulative.begin());
+    ranks[i] = min(ranks[i], nodes - 1);
+  }
+  return ranks;
+}
+
+/**
+ * @brief Time looking up every key
+ *
+ * @pre none
+ * @post tree has seen every lookup, result line written to cout
+ * @param name label of the run
+ * @param tree tree to search, splays if its access mode says so
+ * @param keys keys to look up
+ */
+void run(const char *name, ThreadedBST<int> &tree, const vector<int> &keys) {
+  using Clock = chrono::steady_clock;
+  Clock::time_point start = Clock::now();
+  size_t hits = 0;
+  for (int key : keys) {
+    hits += tree.contains(key);
+  }
+  double seconds = chrono::duration<double>(Clock::now() - start).count();
+  cout << setw(14) << name << setw(14) << keys.size() / seconds / 1e6
+       << setw(10) << tree.stats().averagePathLength << setw(12) << hits
+       << endl;
+}
+
+int main(int argc, char *argv[]) {
+  const int nodes = argc > 1 ? atoi(argv[1]) : 1 << 20;
+  const size_t lookups = argc > 2 ? strtoul(argv[2], nullptr, 10) : 1 << 22;
+
+  // Keys 1 to nodes added in random order, hot ranks spread over the keys
+  mt19937 rng(42);
+  vector<int> order(nodes);
+  for (int i = 0; i < nodes; i++) {
+    order[i] = i + 1;
+  }
+  shuffle(order.begin(), order.end(), rng);
+  ThreadedBST<int> unbalanced;
+  for (int key : order) {
+    unbalanced.add(nullptr, key);
+  }
+  shuffle(order.begin(), order.end(), rng);
+
+  cout << nodes << " nodes, " << lookups << " lookups" << endl;
+  cout << fixed << setprecision(2);
+  for (double skew : {0.8, 1.0, 1.2}) {
+    vector<int> keys = zipfRanks(nodes, lookups, skew, rng);
+    for (int &key : keys) {
+      key = order[key];
+    }
+    cout << endl << "zipf skew " << skew << endl;
+    cout << setw(14) << "mode" << setw(14) << "Mlookups/s" << setw(10)
+         << "node depth" << setw(12) << "hits" << endl;
+
+    ThreadedBST<int> plain(unbalanced);
+    run("unbalanced", plain, keys);
+    ThreadedBST<int> balanced(unbalanced);
+    balanced.compact();
+    run("balanced", balanced, keys);
+    ThreadedBST<int> splay(unbalanced);
+    splay.setAccessMode(ThreadedBST<int>::ACCESS_SPLAY);
+    run("splay", splay, keys);
+    ThreadedBST<int> semi(unbalanced);
+    semi.setAccessMode(ThreadedBST<int>::ACCESS_SEMI_SPLAY);
+    run("semi-splay", semi, keys);
+    ThreadedBST<int> deep(unbalanced);
+    deep.setAccessMode(ThreadedBST<int>::ACCESS_SEMI_SPLAY, 8);
+    run("semi depth 8", deep, keys);
+  }
+  return 0;
+}
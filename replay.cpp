@@ -0,0 +1,70 @@
+/**
+ * @file replay.cpp
+ * @brief Replays an operation trace against a ThreadedBST and reports
+ *        throughput and latency percentiles per operation type
+ * @author William Susanto and Robel Messele
+ */
+#include "ThreadedBST.h"
+#include "TraceReplayer.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+/**
+ * @brief Print how to run the program
+ *
+ * @pre none
+ * @post usage line written to cerr
+ * @param program name the program was run as
+ * @return int exit status for a bad command line
+ */
+int usage(const char *program) {
+  cerr << "usage: " << program
+       << " <trace> [--rate <factor>] [--preload <n>] [--save <binary>]"
+       << endl;
+  return 1;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    return usage(argv[0]);
+  }
+
+  double speed = 0; // full speed unless paced
+  int preload = 0;
+  const char *saveName = nullptr;
+  for (int i = 2; i < argc; i += 2) {
+    // Every flag takes a value
+    if (i + 1 == argc) {
+      cerr << "missing value for " << argv[i] << endl;
+      return usage(argv[0]);
+    }
+    if (strcmp(argv[i], "--rate") == 0) {
+      speed = atof(argv[i + 1]);
+    } else if (strcmp(argv[i], "--preload") == 0) {
+      preload = atoi(argv[i + 1]);
+    } else if (strcmp(argv[i], "--save") == 0) {
+      saveName = argv[i + 1];
+    } else {
+      cerr << "unknown option " << argv[i] << endl;
+      return usage(argv[0]);
+    }
+  }
+
+  TraceReplayer<ThreadedBST<int>> replayer;
+  if (!replayer.load(argv[1])) {
+    cerr << "cannot read trace " << argv[1] << ": " << replayer.getError()
+         << endl;
+    return 1;
+  }
+  if (saveName != nullptr && !replayer.saveBinary(saveName)) {
+    cerr << "cannot write trace " << saveName << endl;
+    return 1;
+  }
+
+  // Keys 1 to preload are in the tree before the trace starts
+  ThreadedBST<int> tree(preload);
+  replayer.replay(tree, speed);
+  replayer.report(cout);
+  return 0;
+}
@@ -0,0 +1,199 @@
+/**
+ * @file TreeCheck.h
+ * @brief Helpers the tests share: checking a ThreadedBST<int> or a
+ *        PersistentBST<int> against a std::multiset of the keys it
+ *        should hold, and making the same random change to both.
+ * @author William Susanto and Robel Messele
+ */
+#ifndef TREE_CHECK_
+#define TREE_CHECK_
+
+#include "PersistentBST.h"
+#include "ThreadedBST.h"
+#include <cassert>
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Checks the lookups only a ThreadedBST has
+ *
+ * @pre none
+ * @post asserts export, backward iteration, find, lowerBound,
+ *       containsBatch and containsRange agree with keys
+ * @param tree tree to check
+ * @param keys expected keys
+ * @param low smallest key looked up
+ * @param high key just past the ones looked up
+ */
+inline void expectLookups(const ThreadedBST<int> &tree,
+                          const multiset<int> &keys, int low, int high) {
+  assert(tree.toVector() == vector<int>(keys.begin(), keys.end()));
+  // Back from end() to begin() gives the keys in reverse
+  vector<int> backward;
+  ThreadedBST<int>::iterator it = tree.end();
+  while (it != tree.begin()) {
+    --it;
+    backward.push_back(*it);
+  }
+  assert(backward == vector<int>(keys.rbegin(), keys.rend()));
+
+  vector<int> probes;
+  for (int key = low; key < high; key++) {
+    probes.push_back(key);
+  }
+  unique_ptr<bool[]> found(new bool[probes.size() + 1]);
+  tree.containsBatch(probes.data(), probes.size(), found.get());
+  for (size_t i = 0; i < probes.size(); i++) {
+    const int key = probes[i];
+    assert(found[i] == (keys.count(key) > 0));
+    assert((tree.find(key) != tree.end()) == (keys.count(key) > 0));
+    BinaryNode<int> *bound = tree.lowerBound(key);
+    auto expected = keys.lower_bound(key);
+    assert((bound == nullptr) == (expected == keys.end()));
+    assert(bound == nullptr || bound->getItem() == *expected);
+  }
+  for (int first = low; first < high; first += 37) {
+    for (int width : {1, 3, 16, 100, 700}) {
+      const bool present =
+          keys.lower_bound(first) != keys.lower_bound(first + width);
+      assert(tree.containsRange(first, first + width) == present);
+    }
+  }
+}
+
+/**
+ * @brief Checks the lookups only a PersistentBST has
+ *
+ * @pre none
+ * @post asserts size and lowerBound agree with keys
+ * @param tree version to check
+ * @param keys expected keys
+ * @param low smallest key looked up
+ * @param high key just past the ones looked up
+ */
+inline void expectLookups(const PersistentBST<int> &tree,
+                          const multiset<int> &keys, int low, int high) {
+  // Equal keys share a node
+  assert(tree.size() == (int)set<int>(keys.begin(), keys.end()).size());
+  for (int key = low; key < high; key++) {
+    PersistentBST<int>::iterator bound = tree.lowerBound(key);
+    auto expected = keys.lower_bound(key);
+    assert((bound == tree.end()) == (expected == keys.end()));
+    assert(bound == tree.end() || *bound == *expected);
+  }
+}
+
+/**
+ * @brief Checks a tree against the keys it should hold
+ *
+ * @pre none
+ * @post asserts iteration gives exactly keys in order, and contains,
+ *       countOf and the lookups of the tree type agree with keys
+ * @param tree tree to check
+ * @param keys expected keys
+ * @param low smallest key looked up
+ * @param high key just past the ones looked up
+ */
+template <class Tree>
+void expect(const Tree &tree, const multiset<int> &keys, int low,
+            int high) {
+  assert(vector<int>(tree.begin(), tree.end()) ==
+         vector<int>(keys.begin(), keys.end()));
+  for (int key = low; key < high; key++) {
+    assert(tree.contains(key) == (keys.count(key) > 0));
+    assert(tree.countOf(key) == (int)keys.count(key));
+  }
+  expectLookups(tree, keys, low, high);
+}
+
+/**
+ * @brief Adds a copy of a key to a ThreadedBST
+ *
+ * @pre none
+ * @post tree holds one more copy of key
+ * @param tree tree to change
+ * @param key key to add
+ */
+inline void addKey(ThreadedBST<int> &tree, int key) {
+  tree.add(nullptr, key);
+}
+
+/**
+ * @brief Adds a copy of a key to a PersistentBST
+ *
+ * @pre none
+ * @post tree holds one more copy of key
+ * @param tree version to change
+ * @param key key to add
+ */
+inline void addKey(PersistentBST<int> &tree, int key) {
+  tree.add(key);
+}
+
+/**
+ * @brief Removes one copy of a key from a ThreadedBST
+ *
+ * @pre none
+ * @post one copy of key is removed if there was one
+ * @param tree tree to change
+ * @param key key to remove
+ * @return bool true if a copy was removed
+ */
+inline bool removeKey(ThreadedBST<int> &tree, int key) {
+  return tree.extract(key).has_value();
+}
+
+/**
+ * @brief Removes one copy of a key from a PersistentBST
+ *
+ * @pre none
+ * @post one copy of key is removed if there was one
+ * @param tree version to change
+ * @param key key to remove
+ * @return bool true if a copy was removed
+ */
+inline bool removeKey(PersistentBST<int> &tree, int key) {
+  return tree.remove(key);
+}
+
+/**
+ * @brief Make one random change to a tree and its reference
+ *
+ * @pre none
+ * @post tree and keys got the same change: half of the time a key is
+ *       added, otherwise one or every copy of a key is removed
+ * @param tree tree to change
+ * @param keys keys tree should hold
+ * @param rng random source
+ * @param range keys 0 <= k < range are changed
+ */
+template <class Tree>
+void churn(Tree &tree, multiset<int> &keys, mt19937 &rng, int range) {
+  const int key = rng() % range;
+  switch (rng() % 4) {
+  case 0:
+  case 1:
+    addKey(tree, key);
+    keys.insert(key);
+    break;
+  case 2: {
+    const int erased = tree.erase(key);
+    assert(erased == (int)keys.erase(key));
+    break;
+  }
+  default: {
+    const bool removed = removeKey(tree, key);
+    assert(removed == (keys.count(key) > 0));
+    if (removed) {
+      keys.erase(keys.find(key));
+    }
+    break;
+  }
+  }
+}
+
+#endif
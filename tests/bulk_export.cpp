@@ -0,0 +1,201 @@
+/**
+ * @file bulk_export.cpp
+ * @brief Tests copyTo, copyRangeTo and copyChunk against a sorted
+ *        reference: empty and reversed ranges, ranges past either end of
+ *        the keys, buffers smaller than the keys, and chunked exports that
+ *        resume across calls, also partway through the copies of a
+ *        counted key and past tombstones.
+ *        Build: g++ -std=c++17 -I.. bulk_export.cpp -o bulk_export
+ *        Run:   ./bulk_export
+ * @author William Susanto and Robel Messele
+ */
+#include "ThreadedBST.h"
+#include <cassert>
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+
+const int RANGE = 400; // Keys are drawn from 0 <= k < RANGE
+
+/**
+ * @brief Copy a range into a buffer of exactly the given room
+ *
+ * @pre none
+ * @post asserts the keys written are the first of keys in the range
+ * @param tree tree to export
+ * @param keys keys tree holds
+ * @param low smallest key of the range
+ * @param high key just past the range
+ * @param capacity room in the buffer
+ */
+void expectRange(const ThreadedBST<int> &tree, const multiset<int> &keys,
+                 int low, int high, size_t capacity) {
+  // Exact room, so a write past it is caught by the sanitizer
+  unique_ptr<int[]> out(new int[capacity]);
+  const size_t written = tree.copyRangeTo(low, high, out.get(), capacity);
+  vector<int> expected;
+  if (low < high) {
+    expected.assign(keys.lower_bound(low), keys.lower_bound(high));
+  }
+  expected.resize(min(expected.size(), capacity));
+  assert(vector<int>(out.get(), out.get() + written) == expected);
+}
+
+/**
+ * @brief Ranges and prefixes of a tree
+ *
+ * @pre none
+ * @post asserts copyTo and copyRangeTo match keys for ranges inside,
+ *       around, before and after the keys, and for any room
+ * @param tree tree to export
+ * @param keys keys tree holds
+ * @param rng random source
+ */
+void expectRanges(const ThreadedBST<int> &tree, const multiset<int> &keys,
+                  mt19937 &rng) {
+  const vector<int> all(keys.begin(), keys.end());
+  // No room writes nothing
+  assert(tree.copyTo(nullptr, 0) == 0);
+  assert(tree.copyRangeTo(0, RANGE, nullptr, 0) == 0);
+  for (size_t capacity : {(size_t)1, (size_t)7, all.size(), all.size() + 5}) {
+    unique_ptr<int[]> out(new int[capacity]);
+    const size_t written = tree.copyTo(out.get(), capacity);
+    assert(written == min(capacity, all.size()));
+    assert(equal(out.get(), out.get() + written, all.begin()));
+  }
+
+  const size_t wide = all.size() + 1;
+  // Empty and reversed ranges
+  for (int key : {-10, 0, RANGE / 2, RANGE - 1, RANGE + 10}) {
+    expectRange(tree, keys, key, key, wide);
+    expectRange(tree, keys, key + 1, key, wide);
+    expectRange(tree, keys, key, key - 50, wide);
+  }
+  // Past either end, and over everything
+  expectRange(tree, keys, -100, -1, wide);
+  expectRange(tree, keys, -100, 0, wide);
+  expectRange(tree, keys, -100, 1, wide);
+  expectRange(tree, keys, RANGE, RANGE + 100, wide);
+  expectRange(tree, keys, RANGE - 1, RANGE + 100, wide);
+  expectRange(tree, keys, -100, RANGE + 100, wide);
+  expectRange(tree, keys, -100, RANGE + 100, all.size());
+  expectRange(tree, keys, -100, RANGE + 100, all.size() / 2 + 1);
+  if (!all.empty()) {
+    expectRange(tree, keys, all.front(), all.back(), wide);
+    expectRange(tree, keys, all.front(), all.back() + 1, wide);
+    expectRange(tree, keys, all.front() + 1, all.back(), wide);
+  }
+  // Random ranges into random room
+  for (int i = 0; i < 300; i++) {
+    const int low = (int)(rng() % (RANGE + 40)) - 20;
+    const int high = low + (int)(rng() % 120) - 10;
+    expectRange(tree, keys, low, high, 1 + rng() % 40);
+  }
+}
+
+/**
+ * @brief Chunked exports of a tree
+ *
+ * @pre none
+ * @post asserts chunks of each size resume where the last one stopped
+ *       and together give every key from the start position on
+ * @param tree tree to export
+ * @param keys keys tree holds
+ */
+void expectChunks(const ThreadedBST<int> &tree, const multiset<int> &keys) {
+  const vector<int> all(keys.begin(), keys.end());
+  for (size_t capacity : {(size_t)1, (size_t)2, (size_t)3, (size_t)16,
+                          (size_t)1000}) {
+    unique_ptr<int[]> out(new int[capacity]);
+    vector<int> exported;
+    ThreadedBST<int>::iterator from = tree.begin();
+    size_t written;
+    while ((written = tree.copyChunk(from, out.get(), capacity)) > 0) {
+      // Only the last chunk is short
+      assert(written == capacity || from == tree.end());
+      exported.insert(exported.end(), out.get(), out.get() + written);
+      // The position left behind is the next key still to come
+      assert(from == tree.end() || *from == all[exported.size()]);
+    }
+    assert(exported == all && from == tree.end());
+    // At the end it keeps writing nothing
+    assert(tree.copyChunk(from, out.get(), capacity) == 0);
+    assert(from == tree.end());
+  }
+
+  // Room for nothing leaves the position alone
+  ThreadedBST<int>::iterator from = tree.begin();
+  assert(tree.copyChunk(from, nullptr, 0) == 0);
+  assert(from == tree.begin());
+
+  // Starting from a looked up key, and stepping between chunks
+  for (int key : {0, RANGE / 3, RANGE - 1}) {
+    BinaryNode<int> *start = tree.lowerBound(key);
+    ThreadedBST<int>::iterator at(&tree, start);
+    vector<int> exported;
+    int out[5];
+    size_t written;
+    bool step = false;
+    while ((written = tree.copyChunk(at, out, 5)) > 0) {
+      exported.insert(exported.end(), out, out + written);
+      // Every other chunk, take one key through the iterator instead
+      if (step && at != tree.end()) {
+        exported.push_back(*at);
+        ++at;
+      }
+      step = !step;
+    }
+    assert(exported == vector<int>(keys.lower_bound(key), keys.end()));
+  }
+}
+
+/**
+ * @brief Exports of a tree of each kind
+ *
+ * @pre none
+ * @post asserts every export matches keys, empty, full and after
+ *       removals
+ * @param mode how the tree stores duplicates
+ * @param lazy true to leave tombstones
+ */
+void testTree(ThreadedBST<int>::DuplicateMode mode, bool lazy) {
+  mt19937 rng(20);
+  ThreadedBST<int> tree(mode);
+  tree.setLazyDelete(lazy, 0.9);
+  multiset<int> keys;
+  expectRanges(tree, keys, rng);
+  expectChunks(tree, keys);
+
+  // Few distinct keys, so counted ones hold many copies
+  for (int i = 0; i < 600; i++) {
+    const int key = rng() % 5 == 0 ? 7 * (rng() % 8) : rng() % RANGE;
+    tree.add(nullptr, key);
+    keys.insert(key);
+  }
+  assert(tree.toVector() == vector<int>(keys.begin(), keys.end()));
+  expectRanges(tree, keys, rng);
+  expectChunks(tree, keys);
+
+  // Tombstones at the ends and inside chunks and ranges
+  for (int i = 0; i < 250; i++) {
+    const int key = rng() % RANGE;
+    assert(tree.erase(key) == (int)keys.erase(key));
+  }
+  for (int key : {*keys.begin(), *keys.rbegin()}) {
+    assert(tree.erase(key) == (int)keys.erase(key));
+  }
+  assert(!lazy || tree.stats().tombstones > 0);
+  assert(tree.toVector() == vector<int>(keys.begin(), keys.end()));
+  expectRanges(tree, keys, rng);
+  expectChunks(tree, keys);
+}
+
+int main() {
+  for (bool lazy : {false, true}) {
+    testTree(ThreadedBST<int>::DUPLICATE_NODES, lazy);
+    testTree(ThreadedBST<int>::DUPLICATE_COUNTS, lazy);
+  }
+  cout << "bulk_export passed" << endl;
+  return 0;
+}
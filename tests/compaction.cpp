@@ -0,0 +1,133 @@
+/**
+ * @file compaction.cpp
+ * @brief Tests compact() in small slices while keys are added, removed
+ *        and splayed between the slices, checking that it still
+ *        finishes and that no change is lost, and that compacted nodes
+ *        stay valid after split and join hand them to other trees.
+ *        Also checks the memory estimate of nodes in a block.
+ *        Build: g++ -std=c++17 -I.. compaction.cpp -o compaction
+ *        Run:   ./compaction
+ * @author William Susanto and Robel Messele
+ */
+#include "TreeCheck.h"
+
+/**
+ * @brief Compact in slices with changes between every two slices
+ *
+ * @pre none
+ * @post asserts compaction finishes and the tree matches the reference
+ * @param mode how the tree stores duplicates
+ * @param lazy true to leave tombstones
+ */
+void testChurn(ThreadedBST<int>::DuplicateMode mode, bool lazy) {
+  mt19937 rng(4);
+  ThreadedBST<int> tree(mode);
+  tree.setAccessMode(ThreadedBST<int>::ACCESS_SPLAY);
+  tree.setLazyDelete(lazy, 0.9);
+  multiset<int> keys;
+  for (int i = 0; i < 3000; i++) {
+    const int key = rng() % 1000;
+    tree.add(nullptr, key);
+    keys.insert(key);
+  }
+  for (int round = 0; round < 5; round++) {
+    // Copying, building and deleting take about three passes over the
+    // nodes, so a restarting copy would blow through this bound
+    const size_t budget = 50;
+    const int limit = 4 * (int)(keys.size() + 3000) / (int)budget + 10;
+    int slices = 1;
+    while (!tree.compact(budget)) {
+      assert(slices++ < limit);
+      for (int i = 0; i < 5; i++) {
+        churn(tree, keys, rng, 1000);
+        // Splaying rotates nodes under the copy cursor
+        const int key = rng() % 1000;
+        assert(tree.contains(key) == (keys.count(key) > 0));
+      }
+    }
+    expect(tree, keys, 0, 1000);
+    for (int i = 0; i < 200; i++) {
+      churn(tree, keys, rng, 1000);
+    }
+    expect(tree, keys, 0, 1000);
+  }
+}
+
+/**
+ * @brief Compacted nodes handed to other trees by split and join
+ *
+ * @pre none
+ * @post asserts each tree keeps working after the others are gone
+ */
+void testSharedBlocks() {
+  multiset<int> low;
+  multiset<int> high;
+  ThreadedBST<int> upper;
+  {
+    ThreadedBST<int> tree;
+    for (int key = 0; key < 1000; key++) {
+      tree.add(nullptr, key);
+      (key < 500 ? low : high).insert(key);
+    }
+    tree.compact();
+    ThreadedBST<int> lower;
+    tree.split(500, lower, upper);
+    for (int key = 0; key < 500; key += 3) {
+      lower.erase(key);
+      low.erase(key);
+    }
+    expect(lower, low, 0, 1000);
+  }
+  // The block outlived the tree that made it and the other half
+  for (int key = 500; key < 1000; key += 2) {
+    upper.erase(key);
+    high.erase(key);
+  }
+  expect(upper, high, 0, 1000);
+
+  ThreadedBST<int> left;
+  for (int key : low) {
+    left.add(nullptr, key);
+  }
+  left.compact();
+  ThreadedBST<int> joined;
+  joined.join(left, upper);
+  multiset<int> all(low);
+  all.insert(high.begin(), high.end());
+  expect(joined, all, 0, 1000);
+  joined.compact();
+  expect(joined, all, 0, 1000);
+}
+
+/**
+ * @brief Memory estimate of nodes in a block and on the heap
+ *
+ * @pre none
+ * @post asserts block nodes are counted without a malloc header
+ */
+void testMemoryEstimate() {
+  ThreadedBST<int> tree;
+  for (int key = 0; key < 1000; key++) {
+    tree.add(nullptr, key * 7 % 1000);
+  }
+  const TreeShape heap = tree.stats();
+  assert(heap.blockNodes == 0);
+  tree.compact();
+  tree.add(nullptr, 1000);
+  const TreeShape mixed = tree.stats();
+  assert(mixed.nodes == 1001 && mixed.blockNodes == 1000);
+  assert(mixed.memoryBytes - sizeof(tree) ==
+         1000 * sizeof(BinaryNode<int>) +
+             (heap.memoryBytes - sizeof(tree)) / 1000);
+}
+
+int main() {
+  for (bool lazy : {false, true}) {
+    testChurn(ThreadedBST<int>::DUPLICATE_NODES, lazy);
+    testChurn(ThreadedBST<int>::DUPLICATE_COUNTS, lazy);
+  }
+  testSharedBlocks();
+  testMemoryEstimate();
+  cout << "compaction passed" << endl;
+  return 0;
+}
@@ -0,0 +1,143 @@
+/**
+ * @file contains_batch.cpp
+ * @brief Tests containsBatch and findBatch against single lookups: every
+ *        batch size from empty up past several groups of lanes, batches
+ *        that repeat keys inside a group and across groups, and trees that
+ *        are empty, counted, hold tombstones or have filters.
+ *        Build: g++ -std=c++17 -I.. contains_batch.cpp -o contains_batch
+ *        Run:   ./contains_batch
+ * @author William Susanto and Robel Messele
+ */
+#include "ThreadedBST.h"
+#include <cassert>
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+
+const int RANGE = 300; // Keys are drawn from 0 <= k < RANGE
+
+/**
+ * @brief Checks one batch of probes
+ *
+ * @pre none
+ * @post asserts each result of both batch lookups matches keys, and no
+ *       result is written past the batch
+ * @param tree tree to look in
+ * @param keys keys tree holds
+ * @param probes keys to look for
+ */
+void expectBatch(const ThreadedBST<int> &tree, const multiset<int> &keys,
+                 const vector<int> &probes) {
+  const size_t size = probes.size();
+  // Exact sizes, so a write past the batch is caught by the sanitizer
+  unique_ptr<bool[]> found(new bool[size]);
+  unique_ptr<ThreadedBST<int>::iterator[]> positions(
+      new ThreadedBST<int>::iterator[size]);
+  for (size_t i = 0; i < size; i++) {
+    // The opposite of the answer, so every result must be written
+    found[i] = keys.count(probes[i]) == 0;
+  }
+  tree.containsBatch(probes.data(), size, found.get());
+  tree.findBatch(probes.data(), size, positions.get());
+  for (size_t i = 0; i < size; i++) {
+    const bool present = keys.count(probes[i]) > 0;
+    assert(found[i] == present);
+    assert(found[i] == tree.contains(probes[i]));
+    assert((positions[i] != tree.end()) == present);
+    assert(!present || *positions[i] == probes[i]);
+  }
+}
+
+/**
+ * @brief Batches of every size and with repeated keys
+ *
+ * @pre none
+ * @post asserts each batch matches single lookups
+ * @param tree tree to look in
+ * @param keys keys tree holds
+ * @param rng random source
+ */
+void expectBatches(const ThreadedBST<int> &tree, const multiset<int> &keys,
+                   mt19937 &rng) {
+  // Nothing to look up reads no key and writes no result
+  tree.containsBatch(nullptr, 0, nullptr);
+  tree.findBatch(nullptr, 0, nullptr);
+
+  // Sizes around each multiple of the lanes, random keys in and out
+  const size_t lanes = ThreadedBST<int>::BATCH_LANES;
+  for (size_t size = 0; size <= 4 * lanes + 1; size++) {
+    vector<int> probes;
+    for (size_t i = 0; i < size; i++) {
+      probes.push_back((int)(rng() % (RANGE + 20)) - 10);
+    }
+    expectBatch(tree, keys, probes);
+  }
+
+  // One key over and over, inside a group and across groups
+  for (size_t size : {(size_t)2, lanes, lanes + 1, 3 * lanes - 1}) {
+    for (int key : {-1, 0, 5, RANGE / 2, RANGE - 1, RANGE}) {
+      expectBatch(tree, keys, vector<int>(size, key));
+    }
+  }
+
+  // A group of the same few keys, then a batch from the middle of it
+  vector<int> probes;
+  for (size_t i = 0; i < 5 * lanes + 3; i++) {
+    probes.push_back((int)(i % 3) * 7);
+  }
+  expectBatch(tree, keys, probes);
+  expectBatch(tree, keys, vector<int>(probes.begin() + 3, probes.end() - 1));
+
+  // Every key of the range once, many full groups and a partial one
+  vector<int> every;
+  for (int key = -3; key < RANGE + 3; key++) {
+    every.push_back(key);
+  }
+  expectBatch(tree, keys, every);
+}
+
+/**
+ * @brief Batches on trees of each kind
+ *
+ * @pre none
+ * @post asserts each batch matches single lookups
+ * @param mode how the tree stores duplicates
+ * @param lazy true to leave tombstones
+ * @param filtered true to rule keys out with filters
+ */
+void testTree(ThreadedBST<int>::DuplicateMode mode, bool lazy,
+              bool filtered) {
+  mt19937 rng(16);
+  ThreadedBST<int> tree(mode);
+  tree.setLazyDelete(lazy, 0.9);
+  tree.setFilter(filtered, 10, 0);
+  multiset<int> keys;
+  expectBatches(tree, keys, rng);
+
+  for (int i = 0; i < 400; i++) {
+    const int key = rng() % RANGE;
+    tree.add(nullptr, key);
+    keys.insert(key);
+  }
+  expectBatches(tree, keys, rng);
+
+  // Removed keys stay behind as tombstones in a lazy tree
+  for (int i = 0; i < 200; i++) {
+    const int key = rng() % RANGE;
+    assert(tree.erase(key) == (int)keys.erase(key));
+  }
+  assert(!lazy || tree.stats().tombstones > 0);
+  expectBatches(tree, keys, rng);
+}
+
+int main() {
+  for (bool lazy : {false, true}) {
+    for (bool filtered : {false, true}) {
+      testTree(ThreadedBST<int>::DUPLICATE_NODES, lazy, filtered);
+      testTree(ThreadedBST<int>::DUPLICATE_COUNTS, lazy, filtered);
+    }
+  }
+  cout << "contains_batch passed" << endl;
+  return 0;
+}
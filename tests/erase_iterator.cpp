@@ -0,0 +1,120 @@
+/**
+ * @file erase_iterator.cpp
+ * @brief Tests erase, extract, find and removeEven against std::multiset
+ *        in both duplicate modes, and walks the iterator forward and
+ *        back, stepping back from end() included.
+ *        Build: g++ -std=c++17 -I.. erase_iterator.cpp -o erase_iterator
+ *        Run:   ./erase_iterator
+ * @author William Susanto and Robel Messele
+ */
+#include "TreeCheck.h"
+
+/**
+ * @brief Random erase and extract in one duplicate mode
+ *
+ * @pre none
+ * @post asserts every result and the tree match std::multiset
+ * @param mode how the tree stores duplicates
+ * @param lazy true to leave tombstones
+ */
+void testEraseExtract(ThreadedBST<int>::DuplicateMode mode, bool lazy) {
+  mt19937 rng(3);
+  ThreadedBST<int> tree(mode);
+  tree.setLazyDelete(lazy);
+  multiset<int> keys;
+  for (int step = 0; step < 5000; step++) {
+    const int key = rng() % 200;
+    switch (rng() % 4) {
+    case 0:
+    case 1:
+      tree.add(nullptr, key);
+      keys.insert(key);
+      break;
+    case 2: {
+      optional<int> item = tree.extract(key);
+      assert(item.has_value() == (keys.count(key) > 0));
+      if (item) {
+        assert(*item == key);
+        keys.erase(keys.find(key));
+      }
+      break;
+    }
+    default:
+      assert(tree.erase(key) == (int)keys.erase(key));
+      break;
+    }
+    ThreadedBST<int>::iterator found = tree.find(key);
+    assert((found != tree.end()) == (keys.count(key) > 0));
+    assert(tree.countOf(key) == (int)keys.count(key));
+  }
+  expect(tree, keys, 0, 200);
+}
+
+/**
+ * @brief removeEven on duplicates, also after compact reshaped the tree
+ *
+ * @pre none
+ * @post asserts only odd keys are left
+ */
+void testRemoveEven() {
+  for (bool compacted : {false, true}) {
+    ThreadedBST<int> tree;
+    for (int key : {1, 2, 2, 2, 3, 4, 4, 5, 6}) {
+      tree.add(nullptr, key);
+    }
+    if (compacted) {
+      tree.compact();
+    }
+    tree.removeEven();
+    expect(tree, {1, 3, 5}, 0, 10);
+  }
+  ThreadedBST<int> counted(ThreadedBST<int>::DUPLICATE_COUNTS);
+  for (int key : {2, 2, 3, 8, 8, 8, 9}) {
+    counted.add(nullptr, key);
+  }
+  counted.removeEven();
+  expect(counted, {3, 9}, 0, 10);
+}
+
+/**
+ * @brief Iterator steps over copies, tombstones and the ends
+ *
+ * @pre none
+ * @post asserts each step lands on the expected key
+ */
+void testIterator() {
+  ThreadedBST<int> empty;
+  ThreadedBST<int>::iterator it = empty.end();
+  --it;
+  assert(it == empty.end());
+
+  ThreadedBST<int> counted(ThreadedBST<int>::DUPLICATE_COUNTS);
+  counted.setLazyDelete(true, 0.9);
+  for (int key : {5, 1, 9, 9, 7}) {
+    counted.add(nullptr, key);
+  }
+  counted.erase(7);
+  expect(counted, {1, 5, 9, 9}, 0, 10);
+  it = counted.end();
+  --it;
+  assert(*it == 9 && it.getCopy() == 1);
+  it--;
+  assert(*it == 9 && it.getCopy() == 0);
+  --it;
+  assert(*it == 5);
+  ++it;
+  assert(*it == 9 && it.getCopy() == 0);
+  it.nextKey();
+  assert(it == counted.end());
+}
+
+int main() {
+  for (bool lazy : {false, true}) {
+    testEraseExtract(ThreadedBST<int>::DUPLICATE_NODES, lazy);
+    testEraseExtract(ThreadedBST<int>::DUPLICATE_COUNTS, lazy);
+  }
+  testRemoveEven();
+  testIterator();
+  cout << "erase_iterator passed" << endl;
+  return 0;
+}
@@ -0,0 +1,197 @@
+/**
+ * @file filter.cpp
+ * @brief Tests the lookup filters: after random adds, removals, splits,
+ *        joins, set operations and compaction in slices, no lookup of a
+ *        key in the tree is ruled out by a filter, whether it goes
+ *        through contains, countOf, find, containsBatch or containsRange.
+ *        Build: g++ -std=c++17 -I.. filter.cpp -o filter
+ *        Run:   ./filter
+ * @author William Susanto and Robel Messele
+ */
+#include "TreeCheck.h"
+
+const int RANGE = 2000; // Keys are drawn from 0 <= k < RANGE
+
+/**
+ * @brief Filters through every kind of change
+ *
+ * @pre none
+ * @post asserts the filters never rule out a key of the tree
+ * @param mode how the tree stores duplicates
+ * @param lazy true to leave tombstones
+ * @param prefixBits low key bits a range filter entry drops
+ */
+void testNoFalseNegatives(ThreadedBST<int>::DuplicateMode mode, bool lazy,
+                          int prefixBits) {
+  mt19937 rng(7);
+  ThreadedBST<int> tree(mode);
+  tree.setLazyDelete(lazy, 0.5);
+  tree.setFilter(true, 10, prefixBits);
+  multiset<int> keys;
+  for (int round = 0; round < 6; round++) {
+    // Grow past the filter capacity, then shrink past half of it
+    for (int i = 0; i < 1500; i++) {
+      churn(tree, keys, rng, RANGE);
+    }
+    expect(tree, keys, -5, RANGE + 5);
+    for (int key = 0; key < RANGE; key += 2 + round) {
+      assert(tree.erase(key) == (int)keys.erase(key));
+    }
+    expect(tree, keys, -5, RANGE + 5);
+
+    // Compact with changes between the slices
+    while (!tree.compact(64)) {
+      churn(tree, keys, rng, RANGE);
+    }
+    expect(tree, keys, -5, RANGE + 5);
+
+    // Split into filtered halves and join them back
+    const int pivot = rng() % RANGE;
+    ThreadedBST<int> lower(mode);
+    ThreadedBST<int> upper(mode);
+    lower.setFilter(true, 10, prefixBits);
+    upper.setFilter(true, 10, prefixBits);
+    tree.split(pivot, lower, upper);
+    expect(lower, multiset<int>(keys.begin(), keys.lower_bound(pivot)), -5,
+           RANGE + 5);
+    expect(upper, multiset<int>(keys.lower_bound(pivot), keys.end()), -5,
+           RANGE + 5);
+    tree.join(lower, upper);
+    expect(tree, keys, -5, RANGE + 5);
+  }
+}
+
+/**
+ * @brief Filters after set operations with another tree
+ *
+ * @pre none
+ * @post asserts each result is found through the filters
+ * @param prefixBits low key bits a range filter entry drops
+ */
+void testSetOperations(int prefixBits) {
+  mt19937 rng(8);
+  ThreadedBST<int> tree;
+  tree.setFilter(true, 10, prefixBits);
+  set<int> keys;
+  for (int i = 0; i < 800; i++) {
+    const int key = rng() % RANGE;
+    if (keys.insert(key).second) {
+      tree.add(nullptr, key);
+    }
+  }
+  for (int round = 0; round < 6; round++) {
+    ThreadedBST<int> other;
+    set<int> otherKeys;
+    for (int i = 0; i < 600; i++) {
+      const int key = rng() % RANGE;
+      if (otherKeys.insert(key).second) {
+        other.add(nullptr, key);
+      }
+    }
+    set<int> result;
+    if (round % 3 == 0) {
+      tree.unionWith(other);
+      result = keys;
+      result.insert(otherKeys.begin(), otherKeys.end());
+    } else if (round % 3 == 1) {
+      tree.intersectWith(other);
+      for (int key : keys) {
+        if (otherKeys.count(key) > 0) {
+          result.insert(key);
+        }
+      }
+    } else {
+      tree.differenceWith(other);
+      for (int key : keys) {
+        if (otherKeys.count(key) == 0) {
+          result.insert(key);
+        }
+      }
+    }
+    keys = result;
+    expect(tree, multiset<int>(keys.begin(), keys.end()), -5, RANGE + 5);
+  }
+  tree.differenceWith(tree);
+  expect(tree, {}, -5, RANGE + 5);
+  tree.add(nullptr, 5);
+  expect(tree, {5}, -5, RANGE + 5);
+}
+
+/**
+ * @brief Split and join between trees whose filters differ
+ *
+ * @pre none
+ * @post asserts filters handed over, kept or rebuilt miss no key
+ */
+void testHandOver() {
+  mt19937 rng(13);
+  multiset<int> keys;
+  ThreadedBST<int> tree;
+  tree.setFilter(true, 10, 4);
+  for (int i = 0; i < 1000; i++) {
+    const int key = rng() % RANGE;
+    tree.add(nullptr, key);
+    keys.insert(key);
+  }
+  for (int pivot : {0, 100, 1000, 1900, RANGE}) {
+    const multiset<int> low(keys.begin(), keys.lower_bound(pivot));
+    const multiset<int> high(keys.lower_bound(pivot), keys.end());
+    // Into itself and a tree with the same settings
+    ThreadedBST<int> same;
+    same.setFilter(true, 10, 4);
+    tree.split(pivot, tree, same);
+    expect(tree, low, -5, RANGE + 5);
+    expect(same, high, -5, RANGE + 5);
+    tree.join(tree, same);
+    expect(tree, keys, -5, RANGE + 5);
+    expect(same, {}, -5, RANGE + 5);
+
+    // Into trees with other settings or none, then joined back by each
+    ThreadedBST<int> other;
+    other.setFilter(true, 8, 0);
+    ThreadedBST<int> plain;
+    tree.split(pivot, other, plain);
+    expect(other, low, -5, RANGE + 5);
+    expect(plain, high, -5, RANGE + 5);
+    plain.join(other, plain);
+    expect(plain, keys, -5, RANGE + 5);
+    plain.split(pivot, plain, other);
+    other.join(plain, other);
+    expect(other, keys, -5, RANGE + 5);
+    other.split(pivot, tree, plain);
+    tree.join(tree, plain);
+    expect(tree, keys, -5, RANGE + 5);
+  }
+
+  // Unions that fit in the filters and ones that do not
+  for (int size : {3, 3000}) {
+    ThreadedBST<int> more;
+    for (int i = 0; i < size; i++) {
+      const int key = rng() % (2 * RANGE);
+      if (!more.contains(key)) {
+        more.add(nullptr, key);
+        if (keys.count(key) == 0) {
+          keys.insert(key);
+        }
+      }
+    }
+    tree.unionWith(more);
+    expect(tree, keys, -5, RANGE + 5);
+  }
+}
+
+int main() {
+  for (bool lazy : {false, true}) {
+    for (int prefixBits : {0, 4}) {
+      testNoFalseNegatives(ThreadedBST<int>::DUPLICATE_NODES, lazy,
+                           prefixBits);
+      testNoFalseNegatives(ThreadedBST<int>::DUPLICATE_COUNTS, lazy,
+                           prefixBits);
+    }
+  }
+  testSetOperations(0);
+  testSetOperations(4);
+  testHandOver();
+  cout << "filter passed" << endl;
+  return 0;
+}
@@ -0,0 +1,212 @@
+/**
+ * @file lazy_delete.cpp
+ * @brief Tests lazy deletion: removed keys stay as tombstones that
+ *        lookups and iterators skip, adding a key again revives its
+ *        node, and tombstones are purged once they pass their limit,
+ *        when lazy deletion is turned off or by compact(). Set operations
+ *        only compact a tree that holds tombstones.
+ *        Build: g++ -std=c++17 -I.. lazy_delete.cpp -o lazy_delete
+ *        Run:   ./lazy_delete
+ * @author William Susanto and Robel Messele
+ */
+#include "TreeCheck.h"
+
+/**
+ * @brief Tombstones until the limit, then one purge
+ *
+ * @pre none
+ * @post asserts removed nodes stay linked until they pass maxDead
+ * @param mode how the tree stores duplicates
+ */
+void testPurgeAtLimit(ThreadedBST<int>::DuplicateMode mode) {
+  ThreadedBST<int> tree(mode);
+  tree.setLazyDelete(true, 0.5);
+  multiset<int> keys;
+  for (int key = 0; key < 100; key++) {
+    tree.add(nullptr, key);
+    keys.insert(key);
+  }
+  for (int key = 0; key < 100; key += 2) {
+    assert(tree.erase(key) == 1);
+    keys.erase(key);
+    expect(tree, keys, 0, 100);
+    assert(tree.stats().nodes == 100);
+    assert(tree.stats().tombstones == key / 2 + 1);
+  }
+  // Half the nodes are tombstones, one more passes the limit
+  assert(tree.extract(1));
+  keys.erase(1);
+  assert(tree.stats().tombstones == 0);
+  assert(tree.stats().nodes == (int)keys.size());
+  expect(tree, keys, 0, 100);
+}
+
+/**
+ * @brief Adding a removed key again
+ *
+ * @pre none
+ * @post asserts a counted key revives its tombstone in place
+ */
+void testRevive() {
+  ThreadedBST<int> counted(ThreadedBST<int>::DUPLICATE_COUNTS);
+  counted.setLazyDelete(true, 0.9);
+  for (int key : {4, 2, 6, 6}) {
+    counted.add(nullptr, key);
+  }
+  assert(counted.erase(6) == 2);
+  assert(counted.stats().tombstones == 1);
+  BinaryNode<int> *node = counted.add(nullptr, 6);
+  assert(node->getCount() == 1);
+  assert(counted.stats().tombstones == 0 && counted.stats().nodes == 3);
+  expect(counted, {2, 4, 6}, 0, 8);
+
+  // Separate nodes make a new node and keep the tombstone
+  ThreadedBST<int> nodes;
+  nodes.setLazyDelete(true, 0.9);
+  for (int key : {4, 2, 6}) {
+    nodes.add(nullptr, key);
+  }
+  nodes.erase(6);
+  nodes.add(nullptr, 6);
+  assert(nodes.stats().tombstones == 1 && nodes.stats().nodes == 4);
+  expect(nodes, {2, 4, 6}, 0, 8);
+}
+
+/**
+ * @brief Dropping tombstones on demand
+ *
+ * @pre none
+ * @post asserts compact() and turning lazy deletion off purge them
+ */
+void testExplicitPurge() {
+  ThreadedBST<int> tree;
+  tree.setLazyDelete(true, 0.9);
+  multiset<int> keys;
+  for (int key = 0; key < 50; key++) {
+    tree.add(nullptr, key);
+    keys.insert(key);
+  }
+  for (int key = 0; key < 50; key += 3) {
+    tree.erase(key);
+    keys.erase(key);
+  }
+  assert(tree.stats().tombstones == 17);
+  tree.compact();
+  assert(tree.stats().tombstones == 0);
+  expect(tree, keys, 0, 50);
+
+  for (int key = 1; key < 50; key += 3) {
+    tree.erase(key);
+    keys.erase(key);
+  }
+  assert(tree.stats().tombstones > 0);
+  tree.setLazyDelete(false);
+  assert(tree.stats().tombstones == 0);
+  expect(tree, keys, 0, 50);
+
+  // A tree of nothing but tombstones compacts to empty. removeNode
+  // leaves purging to the caller, so its successor stays valid.
+  ThreadedBST<int> gone;
+  gone.setLazyDelete(true);
+  for (int key = 0; key < 10; key++) {
+    gone.add(nullptr, key);
+  }
+  for (int key = 0; key < 10; key++) {
+    gone.removeNode(nullptr, key);
+  }
+  assert(gone.stats().nodes == 10);
+  gone.compact();
+  assert(gone.stats().nodes == 0);
+  gone.add(nullptr, 3);
+  expect(gone, {3}, 0, 10);
+}
+
+/**
+ * @brief Random removals never leave more tombstones than allowed
+ *
+ * @pre none
+ * @post asserts the limit holds after every erase and extract
+ * @param mode how the tree stores duplicates
+ */
+void testLimitHolds(ThreadedBST<int>::DuplicateMode mode) {
+  mt19937 rng(5);
+  ThreadedBST<int> tree(mode);
+  tree.setLazyDelete(true, 0.3);
+  multiset<int> keys;
+  for (int step = 0; step < 4000; step++) {
+    const int key = rng() % 300;
+    if (rng() % 2) {
+      tree.add(nullptr, key);
+      keys.insert(key);
+    } else if (rng() % 2) {
+      assert(tree.erase(key) == (int)keys.erase(key));
+    } else if (tree.extract(key)) {
+      keys.erase(keys.find(key));
+    }
+    const TreeShape shape = tree.stats();
+    assert(shape.tombstones <= 0.3 * shape.nodes);
+  }
+  expect(tree, keys, 0, 300);
+}
+
+/**
+ * @brief Set operations on trees with and without tombstones
+ *
+ * @pre none
+ * @post asserts only a tree holding tombstones is compacted first, so
+ *       nodes of a tree without any stay where they are
+ */
+void testSetOperationsKeepNodes() {
+  for (bool lazy : {false, true}) {
+    ThreadedBST<int> tree;
+    tree.setLazyDelete(lazy, 0.9);
+    multiset<int> keys;
+    for (int key = 0; key < 200; key += 2) {
+      tree.add(nullptr, key);
+      keys.insert(key);
+    }
+    BinaryNode<int> *node = tree.lowerBound(100);
+    ThreadedBST<int> other;
+    for (int key : {1, 100, 301}) {
+      other.add(nullptr, key);
+    }
+    tree.unionWith(other);
+    keys.insert({1, 301});
+    ThreadedBST<int> none;
+    none.add(nullptr, 7);
+    tree.differenceWith(none);
+    tree.intersectWith(tree);
+    assert(tree.stats().blockNodes == 0);
+    assert(tree.lowerBound(100) == node);
+    expect(tree, keys, 0, 400);
+  }
+
+  // Own tombstones are dropped before combining
+  ThreadedBST<int> tree;
+  tree.setLazyDelete(true, 0.9);
+  for (int key = 0; key < 20; key++) {
+    tree.add(nullptr, key);
+  }
+  tree.erase(5);
+  ThreadedBST<int> other;
+  other.add(nullptr, 5);
+  tree.unionWith(other);
+  assert(tree.stats().tombstones == 0);
+  multiset<int> keys;
+  for (int key = 0; key < 20; key++) {
+    keys.insert(key);
+  }
+  expect(tree, keys, 0, 30);
+}
+
+int main() {
+  testPurgeAtLimit(ThreadedBST<int>::DUPLICATE_NODES);
+  testPurgeAtLimit(ThreadedBST<int>::DUPLICATE_COUNTS);
+  testLimitHolds(ThreadedBST<int>::DUPLICATE_NODES);
+  testLimitHolds(ThreadedBST<int>::DUPLICATE_COUNTS);
+  testRevive();
+  testExplicitPurge();
+  testSetOperationsKeepNodes();
+  cout << "lazy_delete passed" << endl;
+  return 0;
+}
@@ -0,0 +1,137 @@
+/**
+ * @file merge_iterator.cpp
+ * @brief Tests MergeIterator against a sorted reference: k-way merges of
+ *        whole trees and of key ranges, with keys repeated inside and
+ *        across trees and with empty trees, yielding every key or each
+ *        distinct key once, and compares positions of copied iterators.
+ *        Build: g++ -std=c++17 -I.. merge_iterator.cpp -o merge_iterator
+ *        Run:   ./merge_iterator
+ * @author William Susanto and Robel Messele
+ */
+#include "MergeIterator.h"
+#include <cassert>
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+
+/**
+ * @brief Collect what a merge yields
+ *
+ * @pre none
+ * @post return keys from it up to the end iterator
+ * @param it merge to drain
+ * @return vector<int> keys in the order yielded
+ */
+vector<int> drain(MergeIterator<int> it) {
+  vector<int> keys;
+  for (; it != MergeIterator<int>(); ++it) {
+    keys.push_back(*it);
+  }
+  return keys;
+}
+
+/**
+ * @brief Merges of k random trees
+ *
+ * @pre none
+ * @post asserts merged keys come out in sorted order, all of them or
+ *       each distinct one once
+ * @param mode how the trees store duplicates
+ */
+void testOrder(ThreadedBST<int>::DuplicateMode mode) {
+  mt19937 rng(12);
+  for (int k : {1, 2, 3, 5, 8, 17, 64}) {
+    vector<unique_ptr<ThreadedBST<int>>> owned;
+    vector<const ThreadedBST<int> *> trees;
+    multiset<int> all;
+    for (int t = 0; t < k; t++) {
+      owned.emplace_back(new ThreadedBST<int>(mode));
+      // Every third tree is empty, sizes cross the read ahead buffer
+      const int size = (t % 3 == 2) ? 0 : (int)(rng() % 100);
+      for (int i = 0; i < size; i++) {
+        const int key = rng() % 200;
+        owned.back()->add(nullptr, key);
+        all.insert(key);
+      }
+      trees.push_back(owned.back().get());
+    }
+    const set<int> distinct(all.begin(), all.end());
+    assert(drain(MergeIterator<int>(trees)) ==
+           vector<int>(all.begin(), all.end()));
+    assert(drain(MergeIterator<int>(trees, true)) ==
+           vector<int>(distinct.begin(), distinct.end()));
+
+    for (int low : {-1, 0, 37, 150, 199}) {
+      const int high = low + 50;
+      assert(drain(MergeIterator<int>(trees, low, high)) ==
+             vector<int>(all.lower_bound(low), all.lower_bound(high)));
+      assert(drain(MergeIterator<int>(trees, low, high, true)) ==
+             vector<int>(distinct.lower_bound(low),
+                         distinct.lower_bound(high)));
+    }
+  }
+}
+
+/**
+ * @brief Postfix increment and comparing positions
+ *
+ * @pre none
+ * @post asserts copies compare equal only at the same key of the same
+ *       input, and it++ returns the position before moving
+ */
+void testPositions() {
+  ThreadedBST<int> first;
+  ThreadedBST<int> second;
+  for (int key : {1, 3, 3, 5}) {
+    first.add(nullptr, key);
+  }
+  for (int key : {2, 3, 6}) {
+    second.add(nullptr, key);
+  }
+  const vector<const ThreadedBST<int> *> trees = {&first, &second};
+  MergeIterator<int> it(trees);
+  assert(it == it && it != MergeIterator<int>());
+
+  MergeIterator<int> before = it++;
+  assert(*before == 1 && *it == 2);
+  assert(before != it);
+  ++before;
+  assert(before == it);
+
+  // Three copies of 3, two in one tree, are three positions
+  ++it;
+  vector<MergeIterator<int>> threes;
+  while (*it == 3) {
+    threes.push_back(it++);
+  }
+  assert(threes.size() == 3 && *it == 5);
+  for (size_t i = 0; i < threes.size(); i++) {
+    for (size_t j = 0; j < threes.size(); j++) {
+      assert((threes[i] == threes[j]) == (i == j));
+    }
+  }
+
+  // Both copies walk to the end and meet it
+  MergeIterator<int> copy = it;
+  assert(*it++ == 5 && *it++ == 6);
+  assert(it == MergeIterator<int>() && copy != it);
+  copy++;
+  copy++;
+  assert(copy == it);
+
+  // Merges of nothing start at the end
+  assert(MergeIterator<int>(vector<const ThreadedBST<int> *>()) ==
+         MergeIterator<int>());
+  ThreadedBST<int> empty;
+  assert(MergeIterator<int>(vector<const ThreadedBST<int> *>{&empty}) ==
+         MergeIterator<int>());
+}
+
+int main() {
+  testOrder(ThreadedBST<int>::DUPLICATE_NODES);
+  testOrder(ThreadedBST<int>::DUPLICATE_COUNTS);
+  testPositions();
+  cout << "merge_iterator passed" << endl;
+  return 0;
+}
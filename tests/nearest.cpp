@@ -0,0 +1,163 @@
+/**
+ * @file nearest.cpp
+ * @brief Tests floor, ceiling, nearest and kNearest against a sorted
+ *        reference on random keys, and at the extremes of signed and
+ *        unsigned integer keys, where the distance between two keys does
+ *        not fit the key type.
+ *        Build: g++ -std=c++17 -I.. nearest.cpp -o nearest
+ *        Run:   ./nearest
+ * @author William Susanto and Robel Messele
+ */
+#include "ThreadedBST.h"
+#include <cassert>
+#include <limits>
+#include <random>
+#include <set>
+#include <vector>
+
+/**
+ * @brief Get the keys closest to a key by brute force
+ *
+ * @pre none
+ * @post return keys nearest first, the smaller key first on a tie
+ * @param keys keys to rank
+ * @param data key to measure from
+ * @return vector<T> ranked keys
+ */
+template <class T> vector<T> ranked(const multiset<T> &keys, T data) {
+  vector<T> result(keys.begin(), keys.end());
+  // Widest type holding the distance between any two keys
+  auto distance = [data](T key) {
+    return key < data ? (long double)data - key : (long double)key - data;
+  };
+  stable_sort(result.begin(), result.end(), [&](T a, T b) {
+    return distance(a) < distance(b);
+  });
+  return result;
+}
+
+/**
+ * @brief Checks the neighbour lookups of one key
+ *
+ * @pre none
+ * @post asserts floor, ceiling, nearest and kNearest match keys
+ * @param tree tree to check
+ * @param keys keys tree holds
+ * @param data key to look up
+ */
+template <class T>
+void expect(const ThreadedBST<T> &tree, const multiset<T> &keys, T data) {
+  auto above = keys.lower_bound(data);
+  auto beyond = keys.upper_bound(data);
+  BinaryNode<T> *ceiling = tree.ceiling(data);
+  assert((ceiling == nullptr) == (above == keys.end()));
+  assert(ceiling == nullptr || ceiling->getItem() == *above);
+  BinaryNode<T> *floor = tree.floor(data);
+  assert((floor == nullptr) == (beyond == keys.begin()));
+  assert(floor == nullptr || floor->getItem() == *prev(beyond));
+
+  const vector<T> expected = ranked(keys, data);
+  BinaryNode<T> *nearest = tree.nearest(data);
+  assert((nearest == nullptr) == expected.empty());
+  assert(nearest == nullptr || nearest->getItem() == expected[0]);
+  vector<T> out(expected.size() + 1);
+  for (size_t k = 0; k <= expected.size(); k++) {
+    assert(tree.kNearest(data, k, out.data()) == k);
+    assert(equal(out.begin(), out.begin() + k, expected.begin()));
+  }
+  assert(tree.kNearest(data, out.size(), out.data()) == expected.size());
+}
+
+/**
+ * @brief Neighbours among the extreme keys of a type
+ *
+ * @pre T is an integer type
+ * @post asserts every lookup picks the right key
+ */
+template <class T> void testExtremes() {
+  const T low = numeric_limits<T>::min();
+  const T high = numeric_limits<T>::max();
+  const T mid = (T)(low / 2 + high / 2);
+  ThreadedBST<T> tree;
+  multiset<T> keys;
+  for (T key : {low, high}) {
+    tree.add(nullptr, key);
+    keys.insert(key);
+  }
+  // high - low overflows a signed type, so the distances to both ends
+  // only compare right when measured without it
+  for (T data : {low, (T)(low + 1), (T)(mid - 1), mid, (T)(mid + 1), (T)0,
+                 (T)(high - 1), high}) {
+    expect(tree, keys, data);
+  }
+  assert(tree.nearest((T)(mid - 1))->getItem() == low);
+  if (numeric_limits<T>::is_signed) {
+    assert(tree.nearest((T)0)->getItem() == high);
+  }
+
+  for (T key : {(T)(low + 1), (T)(high - 1), (T)0, low}) {
+    tree.add(nullptr, key);
+    keys.insert(key);
+  }
+  for (T data : {low, (T)(low + 2), mid, (T)0, (T)(high - 2), high}) {
+    expect(tree, keys, data);
+  }
+}
+
+/**
+ * @brief Neighbours of random keys
+ *
+ * @pre none
+ * @post asserts lookups inside, between and outside the keys
+ * @param mode how the tree stores duplicates
+ */
+void testRandom(ThreadedBST<int>::DuplicateMode mode) {
+  mt19937 rng(11);
+  ThreadedBST<int> tree(mode);
+  tree.setLazyDelete(true, 0.5);
+  multiset<int> keys;
+  for (int i = 0; i < 60; i++) {
+    const int key = (int)(rng() % 200) - 100;
+    tree.add(nullptr, key);
+    keys.insert(key);
+  }
+  for (int i = 0; i < 20; i++) {
+    const int key = (int)(rng() % 200) - 100;
+    assert(tree.erase(key) == (int)keys.erase(key));
+  }
+  for (int data = -110; data <= 110; data++) {
+    expect(tree, keys, data);
+  }
+}
+
+/**
+ * @brief Neighbours of floating point keys
+ *
+ * @pre none
+ * @post asserts the plain difference is still used for them
+ */
+void testFloating() {
+  ThreadedBST<double> tree;
+  multiset<double> keys;
+  for (double key : {-1e6, -2.5, 0.25, 3.0, 1e6}) {
+    tree.add(nullptr, key);
+    keys.insert(key);
+  }
+  for (double data : {-1e7, -1.0, 0.0, 1.625, 2.0, 1e5}) {
+    expect(tree, keys, data);
+  }
+}
+
+int main() {
+  testExtremes<int>();
+  testExtremes<long long>();
+  testExtremes<short>();
+  testExtremes<signed char>();
+  testExtremes<unsigned>();
+  testExtremes<uint64_t>();
+  testRandom(ThreadedBST<int>::DUPLICATE_NODES);
+  testRandom(ThreadedBST<int>::DUPLICATE_COUNTS);
+  testFloating();
+  cout << "nearest passed" << endl;
+  return 0;
+}
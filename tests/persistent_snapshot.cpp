@@ -0,0 +1,129 @@
+/**
+ * @file persistent_snapshot.cpp
+ * @brief Tests that PersistentBST snapshots are isolated: changing a
+ *        tree after a snapshot, changing the snapshot itself or dropping
+ *        the tree it came from leaves every other version as it was,
+ *        also while threads change their own copies of one version.
+ *        Build: g++ -std=c++17 -pthread -I.. persistent_snapshot.cpp
+ *               -o persistent_snapshot
+ *        Run:   ./persistent_snapshot
+ * @author William Susanto and Robel Messele
+ */
+#include "TreeCheck.h"
+#include <thread>
+
+const int RANGE = 500; // Keys are drawn from 0 <= k < RANGE
+
+/**
+ * @brief Snapshots taken along a run of changes
+ *
+ * @pre none
+ * @post asserts each snapshot keeps the keys it was taken with
+ */
+void testHistory() {
+  mt19937 rng(9);
+  PersistentBST<int> tree;
+  multiset<int> keys;
+  vector<PersistentBST<int>> snapshots;
+  vector<multiset<int>> expected;
+  for (int step = 0; step < 3000; step++) {
+    churn(tree, keys, rng, RANGE);
+    if (step % 100 == 0) {
+      snapshots.push_back(tree.snapshot());
+      expected.push_back(keys);
+    }
+  }
+  expect(tree, keys, -1, RANGE + 1);
+  for (size_t i = 0; i < snapshots.size(); i++) {
+    expect(snapshots[i], expected[i], -1, RANGE + 1);
+  }
+
+  // Changing a snapshot leaves the tree and the other snapshots alone
+  for (size_t i = 0; i < snapshots.size(); i += 2) {
+    for (int step = 0; step < 200; step++) {
+      churn(snapshots[i], expected[i], rng, RANGE);
+    }
+  }
+  expect(tree, keys, -1, RANGE + 1);
+  for (size_t i = 0; i < snapshots.size(); i++) {
+    expect(snapshots[i], expected[i], -1, RANGE + 1);
+  }
+
+  // Versions outlive the tree they were taken from
+  tree = PersistentBST<int>();
+  expect(tree, {}, -1, RANGE + 1);
+  for (size_t i = 0; i < snapshots.size(); i++) {
+    expect(snapshots[i], expected[i], -1, RANGE + 1);
+  }
+}
+
+/**
+ * @brief An iterator over a snapshot while the tree changes
+ *
+ * @pre none
+ * @post asserts the walk sees the keys of the snapshot only
+ */
+void testIteratorIsolation() {
+  PersistentBST<int> tree;
+  for (int key = 0; key < RANGE; key += 2) {
+    tree.add(key);
+  }
+  const PersistentBST<int> snapshot = tree.snapshot();
+  vector<int> seen;
+  for (PersistentBST<int>::iterator it = snapshot.begin();
+       it != snapshot.end(); ++it) {
+    seen.push_back(*it);
+    // Change the nodes the walk has not reached yet in the tree
+    tree.erase(*it + 2);
+    tree.add(*it + 1);
+  }
+  vector<int> even;
+  for (int key = 0; key < RANGE; key += 2) {
+    even.push_back(key);
+  }
+  assert(seen == even);
+}
+
+/**
+ * @brief Threads change their own copies of one version
+ *
+ * @pre none
+ * @post asserts every copy and the shared version hold their own keys
+ */
+void testThreads() {
+  PersistentBST<int> base;
+  multiset<int> baseKeys;
+  for (int key = 0; key < RANGE; key++) {
+    base.add(key);
+    baseKeys.insert(key);
+  }
+  const int THREADS = 4;
+  vector<PersistentBST<int>> copies(THREADS, base);
+  vector<multiset<int>> expected(THREADS, baseKeys);
+  vector<thread> workers;
+  for (int t = 0; t < THREADS; t++) {
+    workers.emplace_back([&copies, &expected, t]() {
+      mt19937 rng(10 + t);
+      for (int step = 0; step < 5000; step++) {
+        churn(copies[t], expected[t], rng, RANGE);
+        // Snapshots taken and dropped touch the shared counts
+        PersistentBST<int> snapshot = copies[t].snapshot();
+      }
+    });
+  }
+  for (thread &worker : workers) {
+    worker.join();
+  }
+  expect(base, baseKeys, -1, RANGE + 1);
+  for (int t = 0; t < THREADS; t++) {
+    expect(copies[t], expected[t], -1, RANGE + 1);
+  }
+}
+
+int main() {
+  testHistory();
+  testIteratorIsolation();
+  testThreads();
+  cout << "persistent_snapshot passed" << endl;
+  return 0;
+}
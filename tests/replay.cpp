@@ -0,0 +1,255 @@
+/**
+ * @file replay.cpp
+ * @brief Tests TraceReplayer on small in-memory traces: text and binary
+ *        traces load and replay into the expected tree, malformed lines,
+ *        unknown operations and truncated records are reported by line or
+ *        record, and keys outside the key type of the tree are refused.
+ *        Build: g++ -std=c++17 -I.. replay.cpp -o replay
+ *        Run:   ./replay
+ * @author William Susanto and Robel Messele
+ */
+#include "ThreadedBST.h"
+#include "TraceReplayer.h"
+#include <cassert>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Load a trace held in a string
+ *
+ * @pre none
+ * @post replayer holds the trace if it parsed
+ * @param replayer replayer to load
+ * @param trace text or binary trace
+ * @return bool false if the trace cannot be parsed
+ */
+template <class TreeType>
+bool loadString(TraceReplayer<TreeType> &replayer, const string &trace) {
+  istringstream input(trace);
+  return replayer.load(input);
+}
+
+/**
+ * @brief Encode one binary trace record
+ *
+ * @pre none
+ * @post return the 25 bytes of the record, fields little endian
+ * @param timestamp recorded time in nanoseconds
+ * @param type operation code, may be out of range
+ * @param key key or start of a scan
+ * @param endKey end of a scan
+ * @return string encoded record
+ */
+string record(long long timestamp, int type, long long key,
+              long long endKey) {
+  string bytes;
+  const long long fields[3] = {timestamp, key, endKey};
+  for (int f = 0; f < 3; f++) {
+    for (int b = 0; b < 8; b++) {
+      bytes += (char)(unsigned char)((unsigned long long)fields[f] >> (8 * b));
+    }
+    if (f == 0) {
+      bytes += (char)type;
+    }
+  }
+  return bytes;
+}
+
+/**
+ * @brief Get the lookup hits and scanned keys of the last replay
+ *
+ * @pre replay has run
+ * @post return the count from the last line of the report
+ * @param replayer replayer to ask
+ * @return long long lookup hits and scanned keys
+ */
+template <class TreeType>
+long long hitsOf(const TraceReplayer<TreeType> &replayer) {
+  ostringstream output;
+  replayer.report(output);
+  const string text = output.str();
+  const string label = "lookup hits and scanned keys: ";
+  const size_t at = text.rfind(label);
+  assert(at != string::npos);
+  return stoll(text.substr(at + label.size()));
+}
+
+/**
+ * @brief Text traces that parse
+ *
+ * @pre none
+ * @post asserts every operation is loaded and replays into the tree
+ */
+void testText() {
+  TraceReplayer<ThreadedBST<int>> replayer;
+  const string trace = "# inserts, a comment and blank lines\n"
+                       "\n"
+                       "100 I 5\n"
+                       "  \t\r\n"
+                       "200 I -3\n"
+                       "300 I 9\r\n"
+                       "400 I 5\n"
+                       "   # indented comment\n"
+                       "500 L 5\n"
+                       "600 L 7\n"
+                       "700 R 9\n"
+                       "800 S -10 6\n"
+                       "900 R 42";
+  assert(loadString(replayer, trace));
+  assert(replayer.getError().empty());
+  assert(replayer.size() == 9);
+
+  ThreadedBST<int> tree;
+  replayer.replay(tree, 0);
+  assert(tree.toVector() == vector<int>({-3, 5, 5}));
+  // One lookup hit and three keys in [-10, 6)
+  assert(hitsOf(replayer) == 4);
+
+  // Replays start from the tree they are given
+  replayer.replay(tree, 0);
+  assert(tree.toVector() == vector<int>({-3, -3, 5, 5, 5, 5}));
+  assert(hitsOf(replayer) == 7);
+
+  // Short traces are not mistaken for binary ones
+  assert(loadString(replayer, "1 I 2\n"));
+  assert(replayer.size() == 1);
+  assert(loadString(replayer, ""));
+  assert(replayer.size() == 0);
+  ThreadedBST<int> empty;
+  replayer.replay(empty, 0);
+  assert(empty.toVector().empty() && hitsOf(replayer) == 0);
+}
+
+/**
+ * @brief Text traces that do not parse
+ *
+ * @pre none
+ * @post asserts each is refused with the number of the bad line, and the
+ *       next good load clears the error
+ */
+void testMalformedText() {
+  TraceReplayer<ThreadedBST<int>> replayer;
+  const vector<pair<string, string>> cases = {
+      {"1 I 1\nfoo I 2\n", "line 2: malformed operation"},
+      {"1 I\n", "line 1: malformed operation"},
+      {"# comment\n\n1 I x\n", "line 3: malformed operation"},
+      {"1 I 1\n2 Q 2\n", "line 2: unknown operation"},
+      {"1 i 1\n", "line 1: unknown operation"},
+      {"1 S 5\n", "line 1: scan without end key"},
+      {"1 S 5 x\n", "line 1: scan without end key"},
+      {"1 I 99999999999999999999\n", "line 1: malformed operation"},
+      {"1 I 3000000000\n", "line 1: key 3000000000 is out of range of the "
+                           "tree's key type"}};
+  for (const auto &bad : cases) {
+    assert(!loadString(replayer, bad.first));
+    assert(replayer.getError() == bad.second);
+  }
+  assert(loadString(replayer, "1 L 1\n"));
+  assert(replayer.getError().empty() && replayer.size() == 1);
+  assert(!replayer.load("no/such/trace"));
+  assert(replayer.getError() == "cannot open no/such/trace");
+}
+
+/**
+ * @brief Keys at the edges of narrow and unsigned key types
+ *
+ * @pre none
+ * @post asserts keys the type holds load, others are refused, and the end
+ *       of a scan may lie outside the type
+ */
+void testKeyFits() {
+  TraceReplayer<ThreadedBST<short>> narrow;
+  assert(loadString(narrow, "1 I -32768\n2 I 32767\n3 S -32768 40000\n"));
+  ThreadedBST<short> shorts;
+  narrow.replay(shorts, 0);
+  assert(shorts.toVector() == vector<short>({-32768, 32767}));
+  assert(hitsOf(narrow) == 2);
+  assert(!loadString(narrow, "1 I 32768\n"));
+  assert(narrow.getError() ==
+         "line 1: key 32768 is out of range of the tree's key type");
+  assert(!loadString(narrow, "1 I 0\n2 L -32769\n"));
+  assert(narrow.getError() ==
+         "line 2: key -32769 is out of range of the tree's key type");
+  assert(!loadString(narrow, "1 S 40000 50000\n"));
+
+  TraceReplayer<ThreadedBST<unsigned>> positive;
+  assert(loadString(positive, "1 I 0\n2 I 4294967295\n"));
+  assert(!loadString(positive, "1 I -1\n"));
+  assert(positive.getError() ==
+         "line 1: key -1 is out of range of the tree's key type");
+  assert(!loadString(positive, "1 I 4294967296\n"));
+
+  // A signed 64 bit key fits every 64 bit type but negatives
+  TraceReplayer<ThreadedBST<uint64_t>> wide;
+  assert(loadString(wide, "1 I 9223372036854775807\n"));
+  assert(!loadString(wide, "1 I -9223372036854775808\n"));
+  TraceReplayer<ThreadedBST<double>> floating;
+  assert(loadString(floating, "1 I -9223372036854775808\n"));
+}
+
+/**
+ * @brief Binary traces that parse and that do not
+ *
+ * @pre none
+ * @post asserts records load and replay like the same text trace, and
+ *       unknown, truncated or out of range records are refused by number
+ */
+void testBinary() {
+  const string magic = "TBSTTRC1";
+  const string records = record(10, OP_INSERT, 4, 0) +
+                         record(20, OP_INSERT, -70000, 0) +
+                         record(30, OP_INSERT, 8, 0) +
+                         record(40, OP_LOOKUP, 8, 0) +
+                         record(50, OP_REMOVE, 4, 0) +
+                         record(60, OP_SCAN, -100000, 100);
+  TraceReplayer<ThreadedBST<int>> replayer;
+  assert(loadString(replayer, magic + records));
+  assert(replayer.getError().empty() && replayer.size() == 6);
+  ThreadedBST<int> tree;
+  replayer.replay(tree, 0);
+  assert(tree.toVector() == vector<int>({-70000, 8}));
+  assert(hitsOf(replayer) == 3);
+
+  // Saved and loaded again it replays the same way
+  const string fileName = "replay_test_trace.bin";
+  assert(replayer.saveBinary(fileName));
+  TraceReplayer<ThreadedBST<int>> reloaded;
+  assert(reloaded.load(fileName));
+  remove(fileName.c_str());
+  assert(reloaded.size() == 6);
+  ThreadedBST<int> again;
+  reloaded.replay(again, 0);
+  assert(again.toVector() == tree.toVector() && hitsOf(reloaded) == 3);
+
+  // Only the magic is an empty trace
+  assert(loadString(replayer, magic));
+  assert(replayer.size() == 0);
+
+  // Every partial record is truncated, however short
+  for (size_t cut = 1; cut < 25; cut++) {
+    assert(!loadString(replayer, magic + records.substr(0, 50 + cut)));
+    assert(replayer.getError() == "record 2: truncated");
+  }
+  assert(!loadString(replayer, magic + record(1, OP_TYPES, 1, 0)));
+  assert(replayer.getError() == "record 0: unknown operation");
+  assert(!loadString(replayer, magic + records + record(1, 200, 1, 0)));
+  assert(replayer.getError() == "record 6: unknown operation");
+
+  TraceReplayer<ThreadedBST<short>> narrow;
+  assert(!loadString(narrow, magic + records));
+  assert(narrow.getError() ==
+         "record 1: key -70000 is out of range of the tree's key type");
+  // The end key of a scan is only compared against
+  assert(loadString(narrow, magic + record(1, OP_SCAN, -5, 1LL << 40)));
+}
+
+int main() {
+  testText();
+  testMalformedText();
+  testKeyFits();
+  testBinary();
+  cout << "replay passed" << endl;
+  return 0;
+}
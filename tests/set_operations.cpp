@@ -0,0 +1,198 @@
+/**
+ * @file set_operations.cpp
+ * @brief Tests split, join, unionWith, intersectWith and differenceWith
+ *        against std::set on random key sets, and on a deep chain of
+ *        sorted insertions that a recursive walk would overflow on.
+ *        Build: g++ -std=c++17 -I.. set_operations.cpp -o set_operations
+ *        Run:   ./set_operations
+ * @author William Susanto and Robel Messele
+ */
+#include "ThreadedBST.h"
+#include <cassert>
+#include <random>
+#include <set>
+#include <vector>
+
+/**
+ * @brief Build a tree holding the given keys in random order
+ *
+ * @pre none
+ * @post tree holds every key once
+ * @param keys keys to add
+ * @param rng random source for the insertion order
+ * @param tree tree to add to
+ */
+void fill(const set<int> &keys, mt19937 &rng, ThreadedBST<int> &tree) {
+  vector<int> order(keys.begin(), keys.end());
+  shuffle(order.begin(), order.end(), rng);
+  for (int key : order) {
+    tree.add(nullptr, key);
+  }
+}
+
+/**
+ * @brief Checks a tree against the keys it should hold
+ *
+ * @pre none
+ * @post asserts the tree holds exactly keys, in order
+ * @param tree tree to check
+ * @param keys expected keys
+ */
+void expect(const ThreadedBST<int> &tree, const set<int> &keys) {
+  assert(tree.toVector() == vector<int>(keys.begin(), keys.end()));
+  for (int key : keys) {
+    assert(tree.contains(key));
+  }
+}
+
+/**
+ * @brief Split at every kind of key and join the halves back
+ *
+ * @pre none
+ * @post asserts both halves and the rejoined tree are correct
+ */
+void testSplitJoin() {
+  mt19937 rng(1);
+  set<int> keys;
+  for (int i = 0; i < 500; i++) {
+    keys.insert(rng() % 2000);
+  }
+  for (int key : {-1, 0, 7, 999, 1000, 1999, 5000}) {
+    ThreadedBST<int> tree;
+    fill(keys, rng, tree);
+    ThreadedBST<int> lower;
+    ThreadedBST<int> upper;
+    tree.split(key, lower, upper);
+    expect(tree, {});
+    expect(lower, set<int>(keys.begin(), keys.lower_bound(key)));
+    expect(upper, set<int>(keys.lower_bound(key), keys.end()));
+
+    tree.join(lower, upper);
+    expect(tree, keys);
+    expect(lower, {});
+    expect(upper, {});
+
+    // Joining into one of the inputs appends the other
+    tree.split(key, lower, upper);
+    lower.join(lower, upper);
+    expect(lower, keys);
+  }
+}
+
+/**
+ * @brief Compare the set operations with std::set on random sets
+ *
+ * @pre none
+ * @post asserts every result matches
+ */
+void testSetOperations() {
+  mt19937 rng(2);
+  for (int round = 0; round < 50; round++) {
+    set<int> a;
+    set<int> b;
+    for (int i = 0; i < 300; i++) {
+      a.insert(rng() % 600);
+      b.insert(rng() % 600);
+    }
+    set<int> both;
+    set<int> either(a);
+    set<int> only;
+    either.insert(b.begin(), b.end());
+    for (int key : a) {
+      (b.count(key) ? both : only).insert(key);
+    }
+
+    ThreadedBST<int> other;
+    fill(b, rng, other);
+    ThreadedBST<int> tree;
+    fill(a, rng, tree);
+    tree.unionWith(other);
+    expect(tree, either);
+
+    ThreadedBST<int> common;
+    fill(a, rng, common);
+    common.intersectWith(other);
+    expect(common, both);
+
+    ThreadedBST<int> rest;
+    fill(a, rng, rest);
+    rest.differenceWith(other);
+    expect(rest, only);
+    expect(other, b);
+  }
+}
+
+/**
+ * @brief Set operations with a tree as deep as it is large
+ *
+ * @pre none
+ * @post asserts the operations finish with the right keys
+ */
+void testDeepOther() {
+  const int size = 200000;
+  ThreadedBST<int> chain;
+  BinaryNode<int> *last = nullptr;
+  for (int i = 0; i < size; i++) {
+    last = chain.add(last, 2 * i);
+  }
+  assert(chain.stats().height == size);
+
+  ThreadedBST<int> tree(1000);
+  tree.unionWith(chain);
+  assert((int)tree.toVector().size() == size + 500);
+
+  ThreadedBST<int> common(1000);
+  common.intersectWith(chain);
+  assert(common.toVector().size() == 500);
+
+  ThreadedBST<int> rest(1000);
+  rest.differenceWith(chain);
+  assert(rest.toVector().size() == 500);
+
+  ThreadedBST<int> copy(chain);
+  copy.differenceWith(chain);
+  assert(copy.toVector().empty());
+}
+
+/**
+ * @brief Split into the tree itself and into trees with other settings
+ *
+ * @pre none
+ * @post asserts both halves keep a height bound and the duplicate mode
+ *       and lazy deletion of the split tree
+ */
+void testSplitSettings() {
+  mt19937 rng(3);
+  for (bool intoSelf : {false, true}) {
+    ThreadedBST<int> tree(ThreadedBST<int>::DUPLICATE_COUNTS);
+    tree.setLazyDelete(true, 0.5);
+    for (int i = 0; i < 1000; i++) {
+      tree.add(nullptr, rng() % 300);
+    }
+    ThreadedBST<int> other;
+    ThreadedBST<int> &lower = intoSelf ? tree : other;
+    ThreadedBST<int> upper;
+    tree.split(150, lower, upper);
+    for (ThreadedBST<int> *side : {&lower, &upper}) {
+      const int bound = side->getDepth();
+      assert(bound >= side->stats().height);
+      assert(side->getDuplicateMode() == ThreadedBST<int>::DUPLICATE_COUNTS);
+      assert(side->getLazyDelete());
+    }
+    // A repeated key is counted in its node, a removed one left behind
+    const int nodes = upper.stats().nodes;
+    upper.add(nullptr, 200);
+    assert(upper.stats().nodes == nodes);
+    upper.erase(200);
+    assert(upper.stats().tombstones == 1);
+  }
+}
+
+int main() {
+  testSplitJoin();
+  testSetOperations();
+  testDeepOther();
+  testSplitSettings();
+  cout << "set_operations passed" << endl;
+  return 0;
+}
@@ -0,0 +1,288 @@
+/**
+ * @file splay.cpp
+ * @brief Tests the access modes: a splayed key ends up at the root, a
+ *        semi-splayed one about halves its depth, nodes above the minimum
+ *        depth stay where they are, and after every rotation the child
+ *        links still order the keys and each thread points at the inorder
+ *        neighbour.
+ *        Build: g++ -std=c++17 -I.. splay.cpp -o splay
+ *        Run:   ./splay
+ * @author William Susanto and Robel Messele
+ */
+#include "TreeCheck.h"
+#include <map>
+
+typedef BinaryNode<int> Node;
+
+/**
+ * @brief Links of a tree with distinct keys
+ */
+struct Links {
+  Node *root = nullptr; // Node no other node has as a child
+  map<int, int> depth;  // Depth of each key, the root is at 0
+  int height = 0;       // Levels, an empty tree has 0
+};
+
+/**
+ * @brief Get a child of a node
+ *
+ * @pre node is not nullptr
+ * @post return the child on one side, nullptr for a thread or for the
+ *       empty link at either end of the tree
+ * @param node node to look below
+ * @param left true for the left child
+ * @return Node* child or nullptr
+ */
+Node *childOf(Node *node, bool left) {
+  if (left) {
+    return node->getLeftThread() ? nullptr : node->getLeftChildPtr();
+  }
+  return node->getRightThread() ? nullptr : node->getRightChildPtr();
+}
+
+/**
+ * @brief Walks the child links below a node
+ *
+ * @pre node is not nullptr
+ * @post inorder holds the nodes below node in inorder, links.depth their
+ *       depths
+ * @param node node to start from
+ * @param level depth of node
+ * @param inorder nodes reached so far
+ * @param links links found so far
+ */
+void walk(Node *node, int level, vector<Node *> &inorder, Links &links) {
+  if (childOf(node, true) != nullptr) {
+    walk(childOf(node, true), level + 1, inorder, links);
+  }
+  inorder.push_back(node);
+  links.depth[node->getItem()] = level;
+  links.height = max(links.height, level + 1);
+  if (childOf(node, false) != nullptr) {
+    walk(childOf(node, false), level + 1, inorder, links);
+  }
+}
+
+/**
+ * @brief Checks the child links and threads of a tree
+ *
+ * @pre every key of tree is distinct and live
+ * @post asserts one node is no child, every other node is the child of
+ *       one node, a walk of the child links gives the keys in order and
+ *       each thread points at the inorder neighbour
+ * @param tree tree to check
+ * @param keys keys tree holds
+ * @return Links root, depths and height of tree
+ */
+Links check(const ThreadedBST<int> &tree, const set<int> &keys) {
+  vector<Node *> nodes;
+  for (int key : keys) {
+    nodes.push_back(tree.lowerBound(key));
+    assert(nodes.back() != nullptr && nodes.back()->getItem() == key);
+  }
+  map<Node *, int> parents;
+  for (Node *node : nodes) {
+    for (bool left : {true, false}) {
+      if (childOf(node, left) != nullptr) {
+        parents[childOf(node, left)]++;
+      }
+    }
+  }
+  Links links;
+  for (Node *node : nodes) {
+    assert(parents.count(node) == 0 || parents[node] == 1);
+    if (parents.count(node) == 0) {
+      assert(links.root == nullptr);
+      links.root = node;
+    }
+  }
+  assert(parents.size() + (links.root != nullptr) == nodes.size());
+  if (links.root == nullptr) {
+    return links;
+  }
+
+  vector<Node *> inorder;
+  walk(links.root, 0, inorder, links);
+  assert(inorder == nodes);
+  for (size_t i = 0; i < nodes.size(); i++) {
+    Node *before = i > 0 ? nodes[i - 1] : nullptr;
+    Node *after = i + 1 < nodes.size() ? nodes[i + 1] : nullptr;
+    // Only the first and last node have an empty link
+    assert(childOf(nodes[i], true) != nullptr ||
+           nodes[i]->getLeftChildPtr() == before);
+    assert(childOf(nodes[i], false) != nullptr ||
+           nodes[i]->getRightChildPtr() == after);
+  }
+  assert(links.height <= tree.getDepth());
+  assert(links.height == tree.stats().height);
+  return links;
+}
+
+/**
+ * @brief Build a tree of distinct random keys
+ *
+ * @pre none
+ * @post tree and keys hold the same random keys
+ * @param tree empty tree to fill
+ * @param keys empty set to fill
+ * @param rng random source
+ * @param size number of keys
+ */
+void fill(ThreadedBST<int> &tree, set<int> &keys, mt19937 &rng, int size) {
+  while ((int)keys.size() < size) {
+    const int key = rng() % (10 * size);
+    if (keys.insert(key).second) {
+      tree.add(nullptr, key);
+    }
+  }
+}
+
+/**
+ * @brief Splayed lookups, hits and misses
+ *
+ * @pre none
+ * @post asserts a key found is moved to the root and a key missed moves
+ *       one of its neighbours there, with intact links each time
+ */
+void testSplay() {
+  mt19937 rng(17);
+  ThreadedBST<int> tree;
+  set<int> keys;
+  fill(tree, keys, rng, 500);
+  const vector<int> sorted(keys.begin(), keys.end());
+  tree.setAccessMode(ThreadedBST<int>::ACCESS_SPLAY);
+  assert(tree.getAccessMode() == ThreadedBST<int>::ACCESS_SPLAY);
+
+  for (int i = 0; i < 300; i++) {
+    const int key = sorted[rng() % sorted.size()];
+    if (i % 2 == 0) {
+      assert(tree.contains(key));
+    } else {
+      ThreadedBST<int>::iterator found = tree.find(key);
+      assert(found != tree.end() && *found == key);
+    }
+    const Links links = check(tree, keys);
+    assert(links.root->getItem() == key);
+  }
+
+  // A miss brings the predecessor or the successor up
+  for (int i = 0; i < 300; i++) {
+    const int key = rng() % 5000;
+    if (keys.count(key) > 0) {
+      continue;
+    }
+    assert(!tree.contains(key));
+    const int root = check(tree, keys).root->getItem();
+    auto after = keys.lower_bound(key);
+    assert((after != keys.end() && root == *after) ||
+           (after != keys.begin() && root == *prev(after)));
+  }
+
+  // Lookups through a const tree leave the shape alone
+  const ThreadedBST<int> &fixed = tree;
+  Node *root = check(tree, keys).root;
+  for (int key : sorted) {
+    assert(fixed.contains(key));
+  }
+  assert(check(tree, keys).root == root);
+  expect(tree, multiset<int>(keys.begin(), keys.end()), -1, 5001);
+}
+
+/**
+ * @brief Nodes above the minimum depth
+ *
+ * @pre none
+ * @post asserts only keys at or below the minimum depth are splayed,
+ *       and the static mode moves nothing
+ */
+void testMinDepth() {
+  mt19937 rng(18);
+  ThreadedBST<int> tree;
+  set<int> keys;
+  fill(tree, keys, rng, 300);
+  const vector<int> sorted(keys.begin(), keys.end());
+  const int minDepth = 4;
+  tree.setAccessMode(ThreadedBST<int>::ACCESS_SPLAY, minDepth);
+  for (int i = 0; i < 300; i++) {
+    const Links before = check(tree, keys);
+    const int key = sorted[rng() % sorted.size()];
+    assert(tree.contains(key));
+    const Links after = check(tree, keys);
+    if (before.depth.at(key) < minDepth) {
+      assert(after.root == before.root && after.depth == before.depth);
+    } else {
+      assert(after.root->getItem() == key);
+    }
+  }
+
+  tree.setAccessMode(ThreadedBST<int>::ACCESS_STATIC);
+  const Links before = check(tree, keys);
+  for (int key : keys) {
+    assert(tree.contains(key) && tree.find(key) != tree.end());
+  }
+  const Links after = check(tree, keys);
+  assert(after.root == before.root && after.depth == before.depth);
+}
+
+/**
+ * @brief Semi-splays and splays of the deepest key of a path
+ *
+ * @pre none
+ * @post asserts each semi-splay about halves the depth of the key and
+ *       the height of the path, and a splay takes the key to the root
+ */
+void testDepthReduction() {
+  const int size = 1024;
+  for (ThreadedBST<int>::AccessMode mode :
+       {ThreadedBST<int>::ACCESS_SEMI_SPLAY, ThreadedBST<int>::ACCESS_SPLAY}) {
+    // Keys added in order make a right spine
+    ThreadedBST<int> tree;
+    set<int> keys;
+    for (int key = 0; key < size; key++) {
+      tree.add(nullptr, key);
+      keys.insert(key);
+    }
+    tree.setAccessMode(mode);
+    Links links = check(tree, keys);
+    assert(links.height == size && links.depth.at(size - 1) == size - 1);
+
+    int depth = size - 1;
+    while (depth > 1) {
+      assert(tree.contains(size - 1));
+      links = check(tree, keys);
+      const int reached = links.depth.at(size - 1);
+      if (mode == ThreadedBST<int>::ACCESS_SPLAY) {
+        assert(reached == 0);
+        // The rest of the path folds to half its length
+        assert(links.height <= size / 2 + 2);
+        break;
+      }
+      assert(reached <= depth / 2 + 1 && reached < depth);
+      assert(links.height <= size / 2 + 2);
+      depth = reached;
+    }
+    expect(tree, multiset<int>(keys.begin(), keys.end()), -1, size + 1);
+  }
+
+  // Semi-splaying random keys shortens a path to a balanced height
+  ThreadedBST<int> tree;
+  set<int> keys;
+  for (int key = 0; key < size; key++) {
+    tree.add(nullptr, key);
+    keys.insert(key);
+  }
+  tree.setAccessMode(ThreadedBST<int>::ACCESS_SEMI_SPLAY);
+  mt19937 rng(19);
+  for (int i = 0; i < 20 * size; i++) {
+    assert(tree.contains(rng() % size));
+  }
+  assert(check(tree, keys).height <= 4 * 10);
+}
+
+int main() {
+  testSplay();
+  testMinDepth();
+  testDepthReduction();
+  cout << "splay passed" << endl;
+  return 0;
+}
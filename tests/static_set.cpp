@@ -0,0 +1,63 @@
+/**
+ * @file static_set.cpp
+ * @brief Tests StaticThreadedSet built at compile time from key tables
+ *        with repeats, against std::set for every table size up to 40.
+ *        Build: g++ -std=c++17 -I.. static_set.cpp -o static_set
+ *        Run:   ./static_set
+ * @author William Susanto and Robel Messele
+ */
+#include "StaticThreadedSet.h"
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <set>
+#include <vector>
+
+static constexpr int table[] = {7, 3, 11, 3, 5, 7, 7};
+static constexpr StaticThreadedSet<int, 7> keys(table);
+static_assert(keys.size() == 4, "repeats are dropped");
+static_assert(keys.contains(3) && keys.contains(5) && keys.contains(7) &&
+                  keys.contains(11),
+              "every key is found");
+static_assert(!keys.contains(4) && !keys.contains(12), "no other key is");
+static_assert(*keys.lowerBound(6) == 7 && keys.lowerBound(12) == keys.end(),
+              "lower bound skips to the next distinct key");
+
+/**
+ * @brief Checks a set built from random keys with many repeats
+ *
+ * @pre none
+ * @post asserts size, lookups and iteration match std::set
+ * @param rng random source
+ */
+template <size_t N> void testTable(mt19937 &rng) {
+  int table[N];
+  set<int> reference;
+  for (size_t i = 0; i < N; i++) {
+    table[i] = rng() % (N / 2 + 1);
+    reference.insert(table[i]);
+  }
+  const StaticThreadedSet<int, N> keys(table);
+  assert(keys.size() == reference.size());
+  assert(vector<int>(keys.begin(), keys.end()) ==
+         vector<int>(reference.begin(), reference.end()));
+  for (int key = -1; key <= (int)N; key++) {
+    assert(keys.contains(key) == (reference.count(key) > 0));
+    typename StaticThreadedSet<int, N>::iterator bound = keys.lowerBound(key);
+    auto expected = reference.lower_bound(key);
+    assert((bound == keys.end()) == (expected == reference.end()));
+    if (expected != reference.end()) {
+      assert(*bound == *expected);
+    }
+  }
+  if constexpr (N < 40) {
+    testTable<N + 1>(rng);
+  }
+}
+
+int main() {
+  mt19937 rng(6);
+  testTable<1>(rng);
+  cout << "static_set passed" << endl;
+  return 0;
+}
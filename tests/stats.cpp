@@ -0,0 +1,331 @@
+/**
+ * @file stats.cpp
+ * @brief Tests the operation statistics: counters advance by what each
+ *        walk does, every public operation records one latency sample
+ *        however many timed calls it nests, histograms bucket and rank
+ *        values within their precision, and the JSON export holds every
+ *        field with the values the getters return.
+ *        Build: g++ -std=c++17 -DTHREADEDBST_STATS -I.. stats.cpp -o stats
+ *        Run:   ./stats
+ * @author William Susanto and Robel Messele
+ */
+#ifndef THREADEDBST_STATS
+#define THREADEDBST_STATS
+#endif
+#include "ThreadedBST.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Reads one JSON value into flat paths
+ *
+ * @pre text[at] starts a value of the form toJson writes: an object,
+ *      an unsigned number or null
+ * @post at is just past the value, fields holds each number or null
+ *       under its dotted path
+ * @param text JSON to read
+ * @param at position in text
+ * @param path dotted path of the value
+ * @param fields flat fields read so far
+ */
+void parseValue(const string &text, size_t &at, const string &path,
+                map<string, string> &fields) {
+  assert(at < text.size());
+  if (text[at] != '{') {
+    const size_t end = text.find_first_of(",}", at);
+    assert(end != string::npos && end > at);
+    const string value = text.substr(at, end - at);
+    assert(value == "null" ||
+           value.find_first_not_of("0123456789") == string::npos);
+    // A path read twice is a duplicate field
+    assert(fields.count(path) == 0);
+    fields[path] = value;
+    at = end;
+    return;
+  }
+  at++;
+  while (text[at] != '}') {
+    assert(text[at] == '"');
+    const size_t close = text.find('"', at + 1);
+    assert(close != string::npos && text[close + 1] == ':');
+    const string name = text.substr(at + 1, close - at - 1);
+    at = close + 2;
+    parseValue(text, at, path.empty() ? name : path + "." + name, fields);
+    assert(text[at] == ',' || text[at] == '}');
+    if (text[at] == ',') {
+      at++;
+    }
+  }
+  at++;
+}
+
+/**
+ * @brief Reads the export of the global statistics
+ *
+ * @pre none
+ * @post asserts the export is one well formed object
+ * @return map<string, string> each number or null under its dotted path
+ */
+map<string, string> exportFields() {
+  ostringstream output;
+  TreeStats::global().toJson(output);
+  const string text = output.str();
+  map<string, string> fields;
+  size_t at = 0;
+  parseValue(text, at, "", fields);
+  assert(at == text.size());
+  return fields;
+}
+
+/**
+ * @brief Histogram buckets, ranks and resets
+ *
+ * @pre none
+ * @post asserts small values are exact, larger ones are within one
+ *       sub bucket, and reset empties the histogram
+ */
+void testHistogram() {
+  LatencyHistogram histogram;
+  assert(histogram.getCount() == 0 && histogram.getMax() == 0);
+  assert(histogram.percentile(0.5) == 0);
+
+  // Below the sub bucket count every value has its own bucket
+  for (uint64_t value = 0; value < 16; value++) {
+    histogram.record(value);
+  }
+  assert(histogram.getCount() == 16 && histogram.getMax() == 15);
+  assert(histogram.percentile(0.0) == 0);
+  assert(histogram.percentile(0.5) == 7);
+  assert(histogram.percentile(1.0) == 15);
+  histogram.reset();
+  assert(histogram.getCount() == 0 && histogram.getMax() == 0);
+  assert(histogram.percentile(0.99) == 0);
+
+  // Larger values rank to the lower bound of their bucket, which is
+  // never more than a sixteenth below them
+  mt19937_64 rng(14);
+  vector<uint64_t> values;
+  for (int i = 0; i < 5000; i++) {
+    const uint64_t value = rng() >> (rng() % 64);
+    values.push_back(value);
+    histogram.record(value);
+  }
+  sort(values.begin(), values.end());
+  assert(histogram.getCount() == values.size());
+  assert(histogram.getMax() == values.back());
+  for (double fraction : {0.001, 0.25, 0.5, 0.9, 0.99, 0.999, 1.0}) {
+    const uint64_t exact =
+        values[(size_t)ceil(fraction * values.size()) - 1];
+    const uint64_t ranked = histogram.percentile(fraction);
+    assert(ranked <= exact && exact - ranked <= exact / 16);
+  }
+  for (uint64_t value : {(uint64_t)16, (uint64_t)17, (uint64_t)1000,
+                         ~(uint64_t)0}) {
+    LatencyHistogram one;
+    one.record(value);
+    assert(one.percentile(0.5) <= value &&
+           value - one.percentile(0.5) <= value / 16);
+    assert(one.getMax() == value);
+  }
+}
+
+/**
+ * @brief Counters of lookups and removals
+ *
+ * @pre none
+ * @post asserts each walk counts the nodes it visits and each removal
+ *       counts the case it took
+ */
+void testCounters() {
+  TreeStats &stats = TreeStats::global();
+  ThreadedBST<int> tree;
+  // Keys added in order make a right spine
+  for (int key = 0; key < 10; key++) {
+    tree.add(nullptr, key);
+  }
+  stats.reset();
+  assert(tree.contains(9));
+  assert(stats.get(TreeStats::NODES_VISITED) == 10);
+  assert(stats.get(TreeStats::COMPARISONS) >= 10);
+
+  // Each step of a walk follows a thread or a child
+  stats.reset();
+  int walked = 0;
+  for (int key : tree) {
+    assert(key == walked);
+    walked++;
+  }
+  assert(walked == 10);
+  assert(stats.get(TreeStats::THREAD_FOLLOWS) +
+             stats.get(TreeStats::CHILD_FOLLOWS) >=
+         9);
+
+  //        4
+  //      2   6
+  //     1 3 5 7
+  ThreadedBST<int> shaped;
+  for (int key : {4, 2, 6, 1, 3, 5, 7}) {
+    shaped.add(nullptr, key);
+  }
+  stats.reset();
+  assert(shaped.extract(1).has_value());
+  assert(stats.get(TreeStats::REMOVE_CASE_A) == 1);
+  assert(stats.get(TreeStats::REMOVE_CASE_B) == 0);
+  assert(stats.get(TreeStats::REMOVE_CASE_C) == 0);
+  assert(shaped.extract(2).has_value());
+  assert(stats.get(TreeStats::REMOVE_CASE_B) == 1);
+  assert(stats.get(TreeStats::REMOVE_CASE_C) == 0);
+  assert(shaped.extract(6).has_value());
+  assert(stats.get(TreeStats::REMOVE_CASE_C) == 1);
+  assert(shaped.toVector() == vector<int>({3, 4, 5, 7}));
+}
+
+/**
+ * @brief Latency samples of public operations
+ *
+ * @pre none
+ * @post asserts one sample per call, in the histogram of its operation,
+ *       also when the operation calls other timed ones
+ */
+void testSamples() {
+  TreeStats &stats = TreeStats::global();
+  stats.reset();
+  ThreadedBST<int> tree;
+  for (int key = 0; key < 100; key++) {
+    tree.add(nullptr, (key * 37) % 100);
+  }
+  assert(stats.latency(TreeStats::ADD).getCount() == 100);
+  assert(stats.latency(TreeStats::FIND).getCount() == 0);
+
+  // find, floor and nearest go through other timed lookups
+  for (int key = 0; key < 50; key++) {
+    assert(tree.find(key) != tree.end());
+    assert(tree.floor(key) != nullptr);
+    assert(tree.nearest(key) != nullptr);
+  }
+  assert(stats.latency(TreeStats::FIND).getCount() == 150);
+
+  ThreadedBST<int>::iterator it = tree.begin();
+  for (int step = 0; step < 20; step++) {
+    ++it;
+  }
+  assert(stats.latency(TreeStats::SUCC).getCount() == 20);
+
+  // extract and erase call removeNode, which is timed too
+  for (int key = 0; key < 30; key++) {
+    assert(tree.extract(key).has_value());
+  }
+  assert(tree.erase(40) == 1);
+  assert(stats.latency(TreeStats::REMOVE).getCount() == 31);
+  assert(stats.latency(TreeStats::ADD).getCount() == 100);
+
+  // Threads record into the same counters and histograms
+  stats.reset();
+  const ThreadedBST<int> &shared = tree;
+  vector<thread> workers;
+  for (int t = 0; t < 4; t++) {
+    workers.emplace_back([&shared]() {
+      for (int key = 0; key < 1000; key++) {
+        const int probe = key % 100;
+        assert(shared.contains(probe) == (probe >= 30 && probe != 40));
+      }
+    });
+  }
+  for (thread &worker : workers) {
+    worker.join();
+  }
+  assert(stats.latency(TreeStats::FIND).getCount() == 4000);
+  assert(stats.get(TreeStats::NODES_VISITED) >= 4000);
+}
+
+/**
+ * @brief The JSON export
+ *
+ * @pre none
+ * @post asserts every counter and percentile is exported once, with
+ *       the value its getter returns
+ */
+void testJson() {
+  TreeStats &stats = TreeStats::global();
+  stats.reset();
+  ThreadedBST<int> tree;
+  mt19937 rng(15);
+  for (int i = 0; i < 500; i++) {
+    tree.add(nullptr, rng() % 1000);
+  }
+  for (int i = 0; i < 500; i++) {
+    tree.contains(rng() % 1000);
+    tree.erase(rng() % 1000);
+  }
+  for (int key : tree) {
+    (void)key;
+  }
+  const map<string, string> fields = exportFields();
+
+  const char *counterNames[TreeStats::COUNTERS] = {
+      "comparisons",   "nodes_visited", "child_follows", "thread_follows",
+      "remove_case_a", "remove_case_b", "remove_case_c"};
+  size_t expected = 0;
+  for (int counter = 0; counter < TreeStats::COUNTERS; counter++) {
+    const string path = string("counters.") + counterNames[counter];
+    assert(fields.count(path) > 0);
+    assert(stoull(fields.at(path)) ==
+           stats.get((TreeStats::Counter)counter));
+    expected++;
+  }
+  assert(stats.get(TreeStats::COMPARISONS) > 0);
+
+  const char *opNames[TreeStats::OPERATIONS] = {"add", "remove", "find",
+                                                "succ"};
+  for (int op = 0; op < TreeStats::OPERATIONS; op++) {
+    const LatencyHistogram &histogram =
+        stats.latency((TreeStats::Operation)op);
+    const string path = string("latency_ns.") + opNames[op] + ".";
+    assert(histogram.getCount() > 0);
+    assert(stoull(fields.at(path + "count")) == histogram.getCount());
+    assert(stoull(fields.at(path + "p50")) == histogram.percentile(0.5));
+    assert(stoull(fields.at(path + "p90")) == histogram.percentile(0.9));
+    assert(stoull(fields.at(path + "p99")) == histogram.percentile(0.99));
+    assert(stoull(fields.at(path + "p999")) ==
+           histogram.percentile(0.999));
+    assert(stoull(fields.at(path + "max")) == histogram.getMax());
+    // Percentiles never fall as the rank rises
+    assert(stoull(fields.at(path + "p50")) <=
+               stoull(fields.at(path + "p90")) &&
+           stoull(fields.at(path + "p90")) <=
+               stoull(fields.at(path + "p99")) &&
+           stoull(fields.at(path + "p99")) <=
+               stoull(fields.at(path + "p999")) &&
+           stoull(fields.at(path + "p999")) <=
+               stoull(fields.at(path + "max")));
+    expected += 6;
+  }
+#ifdef THREADEDBST_PERF
+  assert(fields.count("perf.cache_misses") > 0);
+  assert(fields.count("perf.branch_misses") > 0);
+  expected += 2;
+#endif
+  assert(fields.size() == expected);
+
+  // A reset is exported as zeros
+  stats.reset();
+  for (const auto &field : exportFields()) {
+    assert(field.second == "0" || field.second == "null");
+  }
+}
+
+int main() {
+  testHistogram();
+  testCounters();
+  testSamples();
+  testJson();
+  cout << "stats passed" << endl;
+  return 0;
+}